@@ -0,0 +1,537 @@
+#ifndef AISDI_DYNAMIC_GRAPH_H
+#define AISDI_DYNAMIC_GRAPH_H
+
+#include <vector>
+#include <set>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include "Graph.h"
+
+
+namespace aisdi
+{
+    /* keeps articulation points and wide bridges up to date while edges are inserted and removed
+     * graph is kept as biconnected blocks, and a change rebuilds only the blocks it touches:
+     * -> inserting (x, y) inside one connected component merges all blocks on the block-cut tree path from x to y into one block
+     * -> removing (x, y) splits only the block that contained it
+     * edge (u, v) with an articulation point at one end is a wide bridge or not depending only on counts kept here (blocks at a vertex,
+     * degrees, connected components), any other edge depends only on its own block, so wide bridges of each block are cached */
+    class DynamicGraph
+    {
+    public:
+        using size_type = Graph::size_type;
+        using edge = Graph::edge;
+    private:
+        struct Edge_hash
+        {
+            std::size_t operator()(const edge & e) const
+            {
+                return std::hash<size_type>()(e.first * 0x9E3779B97F4A7C15ULL ^ e.second);
+            }
+        };
+
+        struct Block
+        {
+            std::vector<edge> edges;                                           // all edges are (smaller, bigger)
+            std::vector<size_type> vertices;
+            std::vector<edge> separating_edges;                                // sorted, edges whose ends cut this block apart
+        };
+
+        size_type num_of_vertices;
+        size_type num_of_components;
+        std::vector<std::vector<size_type>> adjacency;
+        std::unordered_map<edge, size_type, Edge_hash> block_of_edge;
+        std::vector<Block> blocks;
+        std::vector<size_type> free_blocks;                                    // ids of destroyed blocks, reused by createBlock()
+        std::vector<std::vector<size_type>> blocks_of_vertex;                  // vertex is an articulation point if it is in more than one block
+        std::vector<size_type> component_of;                                   // label of a component is one of its vertices
+        std::vector<size_type> component_size;                                 // indexed by label
+        std::set<edge> wide_bridges;
+        std::set<size_type> articulation_points;
+
+        std::vector<size_type> local_id;                                       // scratch for renumbering vertices of one block
+        std::vector<size_type> vertex_seen, block_seen;                        // scratch for searches, equal to search_epoch if seen
+        std::vector<size_type> vertex_parent, block_parent;
+        size_type search_epoch = 0;
+
+        static edge normalised(size_type v, size_type u)
+        {
+            return edge(std::min(v, u), std::max(v, u));
+        }
+
+        static void eraseValue(std::vector<size_type> & values, size_type value)
+        {
+            auto position = std::find(values.begin(), values.end(), value);
+            if(position != values.end())
+            {
+                *position = values.back();
+                values.pop_back();
+            }
+        }
+
+        /* renumbers vertices of edges to 0 .. n - 1, returns global ids in local order */
+        std::vector<size_type> renumber(const std::vector<edge> & edges)
+        {
+            std::vector<size_type> vertices;
+            ++search_epoch;
+            for(const auto & e : edges)
+            {
+                for(auto v : {e.first, e.second})
+                {
+                    if(vertex_seen[v] != search_epoch)
+                    {
+                        vertex_seen[v] = search_epoch;
+                        local_id[v] = vertices.size();
+                        vertices.push_back(v);
+                    }
+                }
+            }
+            return vertices;
+        }
+
+        /* biconnected blocks of the graph made of given edges, found by Graph on renumbered copy of the edges */
+        std::vector<std::vector<edge>> splitIntoBlocks(const std::vector<edge> & edges)
+        {
+            std::vector<size_type> vertices = renumber(edges);
+            Graph part(vertices.size());
+            part.reserveEdges(edges.size());
+            for(const auto & e : edges)
+                part.createEdge(local_id[e.first], local_id[e.second]);
+            std::vector<std::vector<edge>> result = part.biconnectedComponents().blocks;
+            for(auto & block_edges : result)
+            {
+                for(auto & e : block_edges)
+                    e = normalised(vertices[e.first], vertices[e.second]);
+            }
+            return result;
+        }
+
+        /* wide bridges of a block considered alone, found by the linear engine of Graph on renumbered copy of the block */
+        std::vector<edge> separatingEdgesOf(const std::vector<edge> & edges)
+        {
+            std::vector<size_type> vertices = renumber(edges);
+            std::vector<edge> separating;
+            if(vertices.size() < 4)
+                return separating;
+            Graph block_graph(vertices.size());
+            block_graph.reserveEdges(edges.size());
+            for(const auto & e : edges)
+                block_graph.createEdge(local_id[e.first], local_id[e.second]);
+            for(const auto & e : block_graph.findWideBridges())
+                separating.push_back(normalised(vertices[e.first], vertices[e.second]));
+            std::sort(separating.begin(), separating.end());
+            return separating;
+        }
+
+        /* is block without vertices v and u disconnected, breadth first search over edges of the block only */
+        bool separatesBlock(const Block & block, size_type v, size_type u)
+        {
+            if(block.vertices.size() < 4)
+                return false;
+            renumber(block.edges);
+            size_type n = block.vertices.size();
+            std::vector<size_type> offsets(n + 1, 0), neighbours(2 * block.edges.size());
+            for(const auto & e : block.edges)
+            {
+                ++offsets[local_id[e.first] + 1];
+                ++offsets[local_id[e.second] + 1];
+            }
+            for(size_type w = 0; w < n; ++w)
+                offsets[w + 1] += offsets[w];
+            std::vector<size_type> cursor(offsets.begin(), offsets.end() - 1);
+            for(const auto & e : block.edges)
+            {
+                neighbours[cursor[local_id[e.first]]++] = local_id[e.second];
+                neighbours[cursor[local_id[e.second]]++] = local_id[e.first];
+            }
+            std::vector<bool> reached(n, false);
+            reached[local_id[v]] = reached[local_id[u]] = true;                // removed vertices act as already reached
+            size_type start = 0;
+            while(reached[start])
+                ++start;
+            std::vector<size_type> queue(1, start);
+            reached[start] = true;
+            for(size_type i = 0; i < queue.size(); ++i)
+            {
+                for(size_type j = offsets[queue[i]]; j < offsets[queue[i] + 1]; ++j)
+                {
+                    if(!reached[neighbours[j]])
+                    {
+                        reached[neighbours[j]] = true;
+                        queue.push_back(neighbours[j]);
+                    }
+                }
+            }
+            return queue.size() + 2 < n;
+        }
+
+        size_type createBlock(std::vector<edge> && edges)
+        {
+            size_type id;
+            if(free_blocks.empty())
+            {
+                id = blocks.size();
+                blocks.push_back(Block());
+                block_seen.push_back(0);
+                block_parent.push_back(0);
+            }
+            else
+            {
+                id = free_blocks.back();
+                free_blocks.pop_back();
+            }
+            Block & block = blocks[id];
+            block.separating_edges = separatingEdgesOf(edges);
+            block.vertices = renumber(edges);
+            block.edges = std::move(edges);
+            for(const auto & e : block.edges)
+                block_of_edge[e] = id;
+            for(auto v : block.vertices)
+                blocks_of_vertex[v].push_back(id);
+            return id;
+        }
+
+        void destroyBlock(size_type id)
+        {
+            Block & block = blocks[id];
+            for(auto v : block.vertices)
+                eraseValue(blocks_of_vertex[v], id);
+            block.edges.clear();
+            block.vertices.clear();
+            block.separating_edges.clear();
+            free_blocks.push_back(id);
+        }
+
+        /* blocks on the block-cut tree path from x to y, breadth first search over block and articulation point nodes */
+        std::vector<size_type> blocksBetween(size_type x, size_type y)
+        {
+            std::deque<std::pair<bool, size_type>> queue;                      // (is block, id)
+            ++search_epoch;
+            vertex_seen[x] = search_epoch;
+            queue.push_back(std::make_pair(false, x));
+            size_type last_block = 0;
+            bool found = false;
+            while(!queue.empty() && !found)
+            {
+                auto node = queue.front();
+                queue.pop_front();
+                if(!node.first)
+                {
+                    for(auto b : blocks_of_vertex[node.second])
+                    {
+                        if(block_seen[b] != search_epoch)
+                        {
+                            block_seen[b] = search_epoch;
+                            block_parent[b] = node.second;
+                            queue.push_back(std::make_pair(true, b));
+                        }
+                    }
+                    continue;
+                }
+                for(auto w : blocks[node.second].vertices)
+                {
+                    if(w == y)
+                    {
+                        found = true;
+                        last_block = node.second;
+                        break;
+                    }
+                    if(blocks_of_vertex[w].size() > 1 && vertex_seen[w] != search_epoch)
+                    {
+                        vertex_seen[w] = search_epoch;
+                        vertex_parent[w] = node.second;
+                        queue.push_back(std::make_pair(false, w));
+                    }
+                }
+            }
+            std::vector<size_type> path;
+            for(size_type b = last_block; found; )
+            {
+                path.push_back(b);
+                if(block_parent[b] == x)
+                    break;
+                b = vertex_parent[block_parent[b]];
+            }
+            return path;
+        }
+
+        std::vector<size_type> collectComponent(size_type start)
+        {
+            std::vector<size_type> reached(1, start);
+            ++search_epoch;
+            vertex_seen[start] = search_epoch;
+            for(size_type i = 0; i < reached.size(); ++i)
+            {
+                for(auto neighbour : adjacency[reached[i]])
+                {
+                    if(vertex_seen[neighbour] != search_epoch)
+                    {
+                        vertex_seen[neighbour] = search_epoch;
+                        reached.push_back(neighbour);
+                    }
+                }
+            }
+            return reached;
+        }
+
+        void labelVertices(const std::vector<size_type> & vertices, size_type label)
+        {
+            for(auto v : vertices)
+                component_of[v] = label;
+            component_size[label] = vertices.size();
+        }
+
+        bool isWideBridge(size_type u, size_type v) const
+        {
+            if(num_of_components >= 3)                                         // other components alone leave graph disconnected
+                return true;
+            if(num_of_components == 2)                                         // anything left of own component keeps it disconnected
+                return component_size[component_of[u]] >= 3;
+            size_type blocks_at_u = blocks_of_vertex[u].size(), blocks_at_v = blocks_of_vertex[v].size();
+            if(blocks_at_u > 1 && (blocks_at_u > 2 || adjacency[v].size() > 1))  // u cuts graph into pieces, v is not the whole piece
+                return true;
+            if(blocks_at_v > 1 && (blocks_at_v > 2 || adjacency[u].size() > 1))
+                return true;
+            if(blocks_at_u > 1 || blocks_at_v > 1)
+                return false;
+            const std::vector<edge> & separating = blocks[block_of_edge.at(normalised(u, v))].separating_edges;
+            return std::binary_search(separating.begin(), separating.end(), normalised(u, v));
+        }
+
+        void refreshEdge(size_type v, size_type u)
+        {
+            if(isWideBridge(v, u))
+                wide_bridges.insert(normalised(v, u));
+            else
+                wide_bridges.erase(normalised(v, u));
+        }
+
+        void refreshVertex(size_type v)
+        {
+            if(blocks_of_vertex[v].size() > 1)
+                articulation_points.insert(v);
+            else
+                articulation_points.erase(v);
+            for(auto neighbour : adjacency[v])
+                refreshEdge(v, neighbour);
+        }
+
+        void refreshAll()
+        {
+            for(size_type v = 0; v < num_of_vertices; ++v)
+                refreshVertex(v);
+        }
+
+        struct Change                                                          // state of blocks about to be rebuilt, compared after the rebuild
+        {
+            size_type old_num_of_components;
+            std::vector<size_type> vertices;                                   // vertices of rebuilt blocks and ends of the changed edge
+            std::vector<size_type> old_block_counts;
+            std::vector<edge> old_separating_edges;
+        };
+
+        Change beginChange(const std::vector<size_type> & rebuilt_blocks, size_type v, size_type u)
+        {
+            Change change;
+            change.old_num_of_components = num_of_components;
+            ++search_epoch;
+            auto remember = [this, &change](size_type w)
+            {
+                if(vertex_seen[w] != search_epoch)
+                {
+                    vertex_seen[w] = search_epoch;
+                    change.vertices.push_back(w);
+                    change.old_block_counts.push_back(blocks_of_vertex[w].size());
+                }
+            };
+            remember(v);
+            remember(u);
+            for(auto b : rebuilt_blocks)
+            {
+                for(auto w : blocks[b].vertices)
+                    remember(w);
+                change.old_separating_edges.insert(change.old_separating_edges.end(), blocks[b].separating_edges.begin(), blocks[b].separating_edges.end());
+            }
+            std::sort(change.old_separating_edges.begin(), change.old_separating_edges.end());
+            return change;
+        }
+
+        /* status of an edge depends on block counts and degrees of its ends, and on its block, so only edges at vertices whose counts
+         * changed and edges which started or stopped separating their block are evaluated again
+         * with 3 or more components every edge is a wide bridge, so changes among such counts don't need a full refresh either */
+        void finishChange(const Change & change, const std::vector<size_type> & created_blocks, size_type v, size_type u)
+        {
+            if(change.old_num_of_components != num_of_components && std::min(change.old_num_of_components, num_of_components) < 3)
+            {
+                refreshAll();
+                return;
+            }
+            for(size_type i = 0; i < change.vertices.size(); ++i)
+            {
+                size_type w = change.vertices[i];
+                if(w == v || w == u || blocks_of_vertex[w].size() != change.old_block_counts[i])
+                    refreshVertex(w);
+            }
+            std::vector<edge> new_separating_edges, changed_edges;
+            for(auto b : created_blocks)
+                new_separating_edges.insert(new_separating_edges.end(), blocks[b].separating_edges.begin(), blocks[b].separating_edges.end());
+            std::sort(new_separating_edges.begin(), new_separating_edges.end());
+            std::set_symmetric_difference(change.old_separating_edges.begin(), change.old_separating_edges.end(),
+                                          new_separating_edges.begin(), new_separating_edges.end(), std::back_inserter(changed_edges));
+            for(const auto & e : changed_edges)
+            {
+                if(block_of_edge.count(e) != 0)
+                    refreshEdge(e.first, e.second);
+            }
+        }
+
+    public:
+        explicit DynamicGraph(size_type vertices_amount) : DynamicGraph(vertices_amount, std::vector<edge>())
+        {}
+
+        /* builds all blocks with one search, repeated edges and loops are skipped */
+        DynamicGraph(size_type vertices_amount, const std::vector<edge> & edges) : num_of_vertices(vertices_amount), num_of_components(vertices_amount),
+                                                                                  adjacency(vertices_amount), blocks_of_vertex(vertices_amount),
+                                                                                  component_of(vertices_amount), component_size(vertices_amount, 1),
+                                                                                  local_id(vertices_amount), vertex_seen(vertices_amount, 0),
+                                                                                  vertex_parent(vertices_amount)
+        {
+            std::vector<edge> unique_edges;
+            for(const auto & e : edges)
+            {
+                if(e.first != e.second)
+                    unique_edges.push_back(normalised(e.first, e.second));
+            }
+            std::sort(unique_edges.begin(), unique_edges.end());
+            unique_edges.erase(std::unique(unique_edges.begin(), unique_edges.end()), unique_edges.end());
+            for(const auto & e : unique_edges)
+            {
+                adjacency[e.first].push_back(e.second);
+                adjacency[e.second].push_back(e.first);
+            }
+            for(size_type v = 0; v < num_of_vertices; ++v)
+                component_of[v] = num_of_vertices;
+            for(size_type v = 0; v < num_of_vertices; ++v)
+            {
+                if(component_of[v] == num_of_vertices)
+                {
+                    std::vector<size_type> component = collectComponent(v);
+                    labelVertices(component, v);
+                    num_of_components -= component.size() - 1;
+                }
+            }
+            for(auto & block_edges : splitIntoBlocks(unique_edges))
+                createBlock(std::move(block_edges));
+            refreshAll();
+        }
+
+        explicit DynamicGraph(Graph & graph) : DynamicGraph(graph.getNumOfVertices(), graph.getEdges())
+        {}
+
+        void insertEdge(size_type v, size_type u)
+        {
+            edge new_edge = normalised(v, u);
+            if(v == u || block_of_edge.count(new_edge) != 0)
+                return;
+            std::vector<size_type> merged_blocks;
+            if(component_of[v] == component_of[u])
+                merged_blocks = blocksBetween(v, u);
+            Change change = beginChange(merged_blocks, v, u);
+
+            if(component_of[v] != component_of[u])                             // new edge is a bridge joining two components
+            {
+                size_type small = v, big = u;
+                if(component_size[component_of[small]] > component_size[component_of[big]])
+                    std::swap(small, big);
+                size_type big_label = component_of[big];
+                size_type joined_size = component_size[component_of[small]] + component_size[big_label];
+                labelVertices(collectComponent(small), big_label);
+                component_size[big_label] = joined_size;
+                --num_of_components;
+            }
+            adjacency[v].push_back(u);
+            adjacency[u].push_back(v);
+            if(merged_blocks.size() == 1)                                      // both ends already in one block, it only gains an edge
+            {
+                size_type b = merged_blocks[0];
+                blocks[b].edges.push_back(new_edge);
+                block_of_edge[new_edge] = b;
+                if(!blocks[b].separating_edges.empty())                        // new edge can't make other edges separating, only the opposite
+                    blocks[b].separating_edges = separatingEdgesOf(blocks[b].edges);
+                else if(separatesBlock(blocks[b], v, u))                       // but its own ends may already have been a separation pair
+                    blocks[b].separating_edges.push_back(new_edge);
+                finishChange(change, merged_blocks, v, u);
+                return;
+            }
+            std::vector<edge> merged(1, new_edge);                             // cycle closes, blocks on the way become one block
+            for(auto b : merged_blocks)
+            {
+                merged.insert(merged.end(), blocks[b].edges.begin(), blocks[b].edges.end());
+                destroyBlock(b);
+            }
+            finishChange(change, std::vector<size_type>(1, createBlock(std::move(merged))), v, u);
+        }
+
+        void removeEdge(size_type v, size_type u)
+        {
+            edge old_edge = normalised(v, u);
+            auto position = block_of_edge.find(old_edge);
+            if(position == block_of_edge.end())
+                throw std::out_of_range("in function: removeEdge(), cannot remove non-existing edge");
+            size_type b = position->second;
+            Change change = beginChange(std::vector<size_type>(1, b), v, u);
+            block_of_edge.erase(position);
+            wide_bridges.erase(old_edge);
+            eraseValue(adjacency[v], u);
+            eraseValue(adjacency[u], v);
+
+            std::vector<edge> remaining;
+            for(const auto & e : blocks[b].edges)
+            {
+                if(e != old_edge)
+                    remaining.push_back(e);
+            }
+            destroyBlock(b);
+            std::vector<size_type> created_blocks;
+            if(remaining.empty())                                              // block was a bridge, its component falls apart
+            {
+                size_type label = component_of[v];
+                size_type old_size = component_size[label];
+                std::vector<size_type> v_side = collectComponent(v);
+                if(std::find(v_side.begin(), v_side.end(), label) != v_side.end())  // label stays with the side containing its vertex
+                {
+                    labelVertices(v_side, label);
+                    labelVertices(collectComponent(u), u);
+                }
+                else
+                {
+                    labelVertices(v_side, v);
+                    component_size[label] = old_size - v_side.size();
+                }
+                ++num_of_components;
+            }
+            else
+            {
+                for(auto & block_edges : splitIntoBlocks(remaining))
+                    created_blocks.push_back(createBlock(std::move(block_edges)));
+            }
+            finishChange(change, created_blocks, v, u);
+        }
+
+        /* same format as Graph::findWideBridges(), (smaller, bigger) in sorted order */
+        std::vector<edge> findWideBridges() const
+        {
+            return std::vector<edge>(wide_bridges.begin(), wide_bridges.end());
+        }
+
+        std::vector<size_type> findArticulationPoints() const
+        {
+            return std::vector<size_type>(articulation_points.begin(), articulation_points.end());
+        }
+    };
+}// namespace
+#endif
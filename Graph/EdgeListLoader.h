@@ -0,0 +1,122 @@
+#ifndef AISDI_EDGE_LIST_LOADER_H
+#define AISDI_EDGE_LIST_LOADER_H
+
+#include <vector>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Graph.h"
+
+
+namespace aisdi
+{
+    /* reads graph description (number of vertices, then one edge "v u" per line) in one go:
+     * regular files are mapped into memory, pipes are read in large blocks, numbers are parsed by hand */
+    class EdgeListLoader
+    {
+    public:
+        using size_type = Graph::size_type;
+    private:
+        static const size_type READ_BLOCK_SIZE = 1 << 20;
+
+        const char* data = nullptr;
+        size_type length = 0;
+        bool is_mapped = false;
+        std::vector<char> buffer;                                              // used when input can't be mapped
+
+        static bool isDigit(char c)
+        {
+            return static_cast<unsigned char>(c - '0') < 10;
+        }
+
+        void readAll(int file_descriptor)
+        {
+            size_type used = 0;
+            while(true)
+            {
+                buffer.resize(used + READ_BLOCK_SIZE);
+                ssize_t bytes_read = ::read(file_descriptor, buffer.data() + used, READ_BLOCK_SIZE);
+                if(bytes_read < 0)
+                    throw std::runtime_error("in EdgeListLoader: cannot read input");
+                if(bytes_read == 0)
+                    break;
+                used += bytes_read;
+            }
+            buffer.resize(used);
+            data = buffer.data();
+            length = used;
+        }
+
+        /* first pass, so the edge list can be allocated exactly once */
+        size_type countNumbers() const
+        {
+            size_type numbers = 0;
+            bool in_number = false;
+            for(size_type i = 0; i < length; ++i)
+            {
+                bool digit = isDigit(data[i]);
+                if(digit && !in_number)
+                    ++numbers;
+                in_number = digit;
+            }
+            return numbers;
+        }
+
+        bool parseNumber(const char* & position, size_type & value) const
+        {
+            const char* end = data + length;
+            while(position != end && !isDigit(*position))
+                ++position;
+            if(position == end)
+                return false;
+            value = 0;
+            while(position != end && isDigit(*position))
+                value = value * 10 + (*position++ - '0');
+            return true;
+        }
+
+    public:
+        explicit EdgeListLoader(int file_descriptor)
+        {
+            struct stat file_info;
+            if(::fstat(file_descriptor, &file_info) == 0 && S_ISREG(file_info.st_mode) && file_info.st_size > 0)
+            {
+                void* mapping = ::mmap(nullptr, file_info.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+                if(mapping != MAP_FAILED)
+                {
+                    ::madvise(mapping, file_info.st_size, MADV_SEQUENTIAL);
+                    data = static_cast<const char*>(mapping);
+                    length = file_info.st_size;
+                    is_mapped = true;
+                    return;
+                }
+            }
+            readAll(file_descriptor);
+        }
+
+        EdgeListLoader(const EdgeListLoader&) = delete;
+        EdgeListLoader& operator=(const EdgeListLoader&) = delete;
+
+        ~EdgeListLoader()
+        {
+            if(is_mapped)
+                ::munmap(const_cast<char*>(data), length);
+        }
+
+        Graph load() const
+        {
+            const char* position = data;
+            size_type num_of_vertices = 0, v, u;
+            size_type num_of_edges = countNumbers() / 2;                       // first number is amount of vertices, incomplete last pair is dropped
+            parseNumber(position, num_of_vertices);
+
+            Graph G(num_of_vertices);
+            G.reserveEdges(num_of_edges);
+            for(size_type i = 0; i < num_of_edges && parseNumber(position, v) && parseNumber(position, u); ++i)
+                G.createEdge(v, u);
+            return G;
+        }
+    };
+}// namespace
+#endif
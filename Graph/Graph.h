@@ -4,6 +4,20 @@
 #define AISDI_GRAPH_H
 
 #include <vector>
+#include <utility>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <thread>
+#include <mutex>
 
 
 namespace aisdi
@@ -13,14 +27,43 @@ namespace aisdi
     public:
         using size_type = std::size_t;
         using edge = std::pair<size_type, size_type>;
+
+        enum Wide_bridges_mode {LINEAR_SEARCH, GHOST_SEARCH, PARALLEL_GHOST_SEARCH};   // GHOST_SEARCH is the old O(V*(V+E)) loop, kept to cross-check results
+
+        /* biconnected blocks and articulation points linked into a tree (a forest for disconnected graph), isolated vertices are in no block */
+        struct Block_cut_tree
+        {
+            std::vector<std::vector<edge>> blocks;                             // edges of each block as (smaller, bigger), one edge block is a bridge
+            std::vector<size_type> articulation_points;                        // sorted
+            std::vector<edge> tree_edges;                                      // (block id, articulation point lying in that block)
+        };
     private:
-        enum Possible_states {NOT_VISITED, VISITED, GHOST};                    // states in DFS search, GHOST is 'invisible' for one DFS iteration
+        enum Possible_states {NOT_VISITED, VISITED, GHOST, ARTICULATION_POINT}; // states in DFS search, GHOST is 'invisible' for one DFS iteration
+                                                                               // ARTICULATION_POINT is VISITED vertex already reported
 
-        class Vertex
+        struct Dfs_frame                                                       // explicit stack frame used instead of recursion
         {
+            size_type vertex;
+            size_type cursor;                                                  // position of the next neighbour to look at in csr_neighbours
+        };
+
+        class Neighbours                                                       // view of one row of the adjacency array, usable in range-for
+        {
+            const size_type* first;
+            const size_type* last;
         public:
-            size_type vertex_id;
-            size_type dfs_id = 0;                                              // always higher than 1
+            Neighbours(const size_type* from, const size_type* to) : first(from), last(to) {}
+            const size_type* begin() const { return first; }
+            const size_type* end() const { return last; }
+            size_type size() const { return last - first; }
+        };
+
+        /* per vertex search data kept in separate arrays, so DFS touches only what it needs
+         * it is allocated by the search itself (one per thread), so creating or mapping a graph costs nothing per vertex */
+        struct Search_scratch
+        {
+            std::vector<Possible_states> state;
+            std::vector<size_type> dfs_id;                                     // always higher than 1
 
             /* low is MIN{dfs_id of current vertex, dfs_id of vertex connected with current vertex by back edge, low of each child in spanning tree} */
             
@@ -29,77 +72,751 @@ namespace aisdi
              * because if low of child >= dfs_id of current vertex, it means that child has no back edge, the only way to the rest of a graph 
              * leads through its parent */
 
-            size_type low = 0;                                                 // used to tell if vertex is articulation point
-            Possible_states state = NOT_VISITED;
-            std::vector<size_type> adjacent_vertices;
+            std::vector<size_type> low;                                        // used to tell if vertex is articulation point
+            std::vector<Dfs_frame> dfs_stack;                                  // reused by DFSfindArticulationPoints, grows to the depth of the spanning tree
+            std::vector<size_type> articulation_points;
+            std::vector<size_type> reported_with_ghost;                        // ghost_id + 1 if edge (ghost_id, vertex) was already reported
+
+            explicit Search_scratch(size_type vertices_amount) : state(vertices_amount, NOT_VISITED), dfs_id(vertices_amount, 0), low(vertices_amount, 0),
+                                                                 reported_with_ghost(vertices_amount, 0)
+            {}
+
+            void clearAllStates()
+            {
+                std::fill(state.begin(), state.end(), NOT_VISITED);
+            }
 
-            void setAdjacentTo(size_type vertex)
+            bool vertexWasNotVisited(size_type vertex) const
             {
-                adjacent_vertices.push_back(vertex);
+                return state[vertex] == NOT_VISITED;
+            }
+
+            bool vertexIsGhost(size_type vertex) const
+            {
+                return state[vertex] == GHOST;
+            }
+        };
+
+        /* hands out ghost ids to worker threads, each worker starts with its own range and steals half of someone else's when it runs dry */
+        class Ghost_scheduler
+        {
+            struct Worker_range
+            {
+                std::mutex lock;
+                size_type next;
+                size_type end;
+            };
+            std::vector<std::unique_ptr<Worker_range>> ranges;
+
+        public:
+            Ghost_scheduler(size_type num_of_ghosts, size_type num_of_workers)
+            {
+                for(size_type worker = 0; worker < num_of_workers; ++worker)
+                {
+                    ranges.emplace_back(new Worker_range);
+                    ranges[worker]->next = num_of_ghosts * worker / num_of_workers;
+                    ranges[worker]->end = num_of_ghosts * (worker + 1) / num_of_workers;
+                }
+            }
+
+            bool takeGhost(size_type worker, size_type & ghost_id)
+            {
+                Worker_range & own = *ranges[worker];
+                {
+                    std::lock_guard<std::mutex> guard(own.lock);
+                    if(own.next < own.end)
+                    {
+                        ghost_id = own.next++;
+                        return true;
+                    }
+                }
+                for(size_type i = 1; i < ranges.size(); ++i)
+                {
+                    Worker_range & victim = *ranges[(worker + i) % ranges.size()];
+                    size_type stolen_begin, stolen_end;
+                    {
+                        std::lock_guard<std::mutex> guard(victim.lock);
+                        if(victim.next == victim.end)
+                            continue;
+                        stolen_end = victim.end;
+                        stolen_begin = victim.end - (victim.end - victim.next + 1) / 2;
+                        victim.end = stolen_begin;
+                    }
+                    std::lock_guard<std::mutex> guard(own.lock);
+                    ghost_id = stolen_begin;
+                    own.next = stolen_begin + 1;
+                    own.end = stolen_end;
+                    return true;
+                }
+                return false;
             }
         };
 
         size_type num_of_vertices;
-        std::vector<Vertex> vector_of_vertices;
 
-        void clearAllStates()
+        /* snapshot file: header, then num_of_vertices + 1 offsets, then num_of_adjacent neighbours, all in native byte order */
+        struct Snapshot_header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t word_size;                                           // sizeof(size_type) of the writer
+            std::uint64_t byte_order_mark;
+            std::uint64_t num_of_vertices;
+            std::uint64_t num_of_adjacent;                                     // twice the number of edges
+        };
+
+        static const char* snapshotMagic() { return "AISDIGR"; }
+        static const std::uint32_t SNAPSHOT_VERSION = 1;
+        static const std::uint64_t BYTE_ORDER_MARK = 0x0102030405060708ULL;
+
+        /* edges are only collected by createEdge, before first search they are frozen into CSR form:
+         * neighbours of v are csr_neighbours[csr_offsets[v]] .. csr_neighbours[csr_offsets[v + 1] - 1]
+         * csr arrays point either into adjacency vectors below or straight into mapped snapshot file */
+        std::vector<edge> created_edges;
+        std::vector<size_type> adjacency_offsets;
+        std::vector<size_type> adjacent_vertices;
+        bool adjacency_is_frozen = false;
+        std::shared_ptr<const void> snapshot;                                  // unmapped when the last graph using it is gone
+        const size_type* csr_offsets = nullptr;                                // refreshed by freezeAdjacency(), so copies of a graph stay valid
+        const size_type* csr_neighbours = nullptr;
+
+        /* two passes over created edges: count degrees, then place neighbours in the order in which edges were created */
+        void freezeAdjacency()
         {
-            for(size_type i = 0; i < num_of_vertices; i++)
-                vector_of_vertices[i].state = NOT_VISITED;
+            if(snapshot)
+                return;
+            if(adjacency_is_frozen)
+            {
+                csr_offsets = adjacency_offsets.data();
+                csr_neighbours = adjacent_vertices.data();
+                return;
+            }
+            adjacency_offsets.assign(num_of_vertices + 1, 0);
+            for(const auto & e : created_edges)
+            {
+                ++adjacency_offsets[e.first + 1];
+                ++adjacency_offsets[e.second + 1];
+            }
+            for(size_type v = 0; v < num_of_vertices; ++v)
+                adjacency_offsets[v + 1] += adjacency_offsets[v];
+            adjacent_vertices.resize(adjacency_offsets[num_of_vertices]);
+            std::vector<size_type> cursor(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for(const auto & e : created_edges)
+            {
+                adjacent_vertices[cursor[e.first]++] = e.second;
+                adjacent_vertices[cursor[e.second]++] = e.first;
+            }
+            adjacency_is_frozen = true;
+            csr_offsets = adjacency_offsets.data();
+            csr_neighbours = adjacent_vertices.data();
         }
 
-        bool vertexWasNotVisited(size_type & vertex) const
+        Neighbours neighboursOf(size_type vertex) const
         {
-            return vector_of_vertices[vertex].state == NOT_VISITED;
+            return Neighbours(csr_neighbours + csr_offsets[vertex], csr_neighbours + csr_offsets[vertex + 1]);
         }
 
-        bool vertexIsGhost(size_type & vertex) const
+        size_type degreeOf(size_type vertex) const
         {
-            return vector_of_vertices[vertex].state == GHOST;
+            return csr_offsets[vertex + 1] - csr_offsets[vertex];
         }
 
-        /* GHOST vertex is invisible for this function */
-        size_type DFSfindArticulationPoints(size_type vertex, size_type vertex_parent, std::vector<size_type> & articulation_points, size_type dfs_visit_time = 1)
+        /* GHOST vertex is invisible for this function, dfs_id of a vertex is dfs_id of its parent + 1
+         * explicit stack of (vertex, cursor) frames replaces recursion, so paths of any length don't overflow the call stack */
+        size_type DFSfindArticulationPoints(Search_scratch & scratch, size_type vertex, size_type vertex_parent, size_type dfs_visit_time = 1) const
         {
-            bool already_is_articulation_piont = false;                                                                      // to avoid checking each vertex more than once
-            size_type child_low;
-            vector_of_vertices[vertex].state = VISITED;
-            vector_of_vertices[vertex].dfs_id = vector_of_vertices[vertex].low = ++dfs_visit_time;
+            std::vector<Possible_states> & state = scratch.state;
+            std::vector<size_type> & dfs_id = scratch.dfs_id;
+            std::vector<size_type> & low = scratch.low;
+            std::vector<Dfs_frame> & dfs_stack = scratch.dfs_stack;
+            dfs_stack.clear();
+            state[vertex] = VISITED;
+            dfs_id[vertex] = low[vertex] = ++dfs_visit_time;
+            dfs_stack.push_back(Dfs_frame{vertex, csr_offsets[vertex]});
 
-            for(auto neighbour : vector_of_vertices[vertex].adjacent_vertices)
+            while(!dfs_stack.empty())
             {
-                if(neighbour != vertex_parent && !vertexIsGhost(neighbour))                                                  // parent and ghost are ignored
+                size_type current = dfs_stack.back().vertex;
+                size_type current_parent = (dfs_stack.size() > 1) ? dfs_stack[dfs_stack.size() - 2].vertex : vertex_parent;
+                if(dfs_stack.back().cursor < csr_offsets[current + 1])
                 {
-                    if(vertexWasNotVisited(neighbour))
+                    size_type neighbour = csr_neighbours[dfs_stack.back().cursor++];
+                    if(neighbour != current_parent && !scratch.vertexIsGhost(neighbour))                                                 // parent and ghost are ignored
                     {
-                        child_low = DFSfindArticulationPoints(neighbour, vertex, articulation_points, dfs_visit_time);       // recursive search
-                        if(child_low < vector_of_vertices[vertex].low)
-                            vector_of_vertices[vertex].low = child_low;
-                        if(!already_is_articulation_piont && child_low >= vector_of_vertices[vertex].dfs_id)                 // at least one son without back edge
+                        if(scratch.vertexWasNotVisited(neighbour))                                                                    // going deeper instead of recursive call
                         {
-                            already_is_articulation_piont = true;
-                            articulation_points.push_back(vertex);
+                            state[neighbour] = VISITED;
+                            dfs_id[neighbour] = low[neighbour] = dfs_id[current] + 1;
+                            dfs_stack.push_back(Dfs_frame{neighbour, csr_offsets[neighbour]});
                         }
+                        else if(dfs_id[neighbour] < low[current])                                                                // if vertex is connected with back edge with neighbour
+                            low[current] = dfs_id[neighbour];
+                    }
+                }
+                else                                                                                                             // all neighbours checked, returning to parent
+                {
+                    dfs_stack.pop_back();
+                    if(dfs_stack.empty())
+                        break;
+                    size_type child_low = low[current];
+                    if(child_low < low[current_parent])
+                        low[current_parent] = child_low;
+                    if(state[current_parent] != ARTICULATION_POINT && child_low >= dfs_id[current_parent])                       // at least one son without back edge
+                    {
+                        state[current_parent] = ARTICULATION_POINT;                                                              // to avoid checking each vertex more than once
+                        scratch.articulation_points.push_back(current_parent);
                     }
-                    else if(vector_of_vertices[neighbour].dfs_id < vector_of_vertices[vertex].low)                           // if vertex is connected with back edge with neighbour
-                        vector_of_vertices[vertex].low = vector_of_vertices[neighbour].dfs_id;
                 }
             }
-            return vector_of_vertices[vertex].low;
+            return low[vertex];
         }
 
+        /* Tarjan's edge stack: edges are pushed when walked, when child subtree has no back edge above its parent (low >= pre of parent)
+         * the edges above the tree edge leading to this child form one biconnected block and parent is an articulation point,
+         * unless it is a root that closes its first block. One DFS gives blocks (handed to on_block as [first, last) range of edges),
+         * articulation points (appended to articulation_points, each once) and so bridges, which are blocks made of one edge */
+        template<typename Block_visitor>
+        void DFSsplitIntoBlocks(Block_visitor && on_block, std::vector<size_type> & articulation_points) const
+        {
+            struct Block_frame
+            {
+                size_type vertex;
+                size_type cursor;
+                bool parent_skipped;                                           // only one copy of the tree edge is skipped, so parallel edges make a cycle
+                size_type tree_edge_position;                                  // place of the tree edge leading here in edge_stack, its block starts there
+            };
+            std::vector<size_type> pre(num_of_vertices, 0), low(num_of_vertices, 0);
+            std::vector<bool> is_articulation_point(num_of_vertices, false);
+            std::vector<edge> edge_stack;
+            std::vector<Block_frame> stack;
+            size_type visit_time = 0;
 
-    public:
-        Graph(size_type vertices_amount) : num_of_vertices(vertices_amount), vector_of_vertices(vertices_amount)
+            for(size_type root = 0; root < num_of_vertices; ++root)
+            {
+                if(pre[root] != 0)
+                    continue;
+                size_type root_blocks = 0;
+                pre[root] = low[root] = ++visit_time;
+                stack.push_back(Block_frame{root, csr_offsets[root], true, 0});
+                while(!stack.empty())
+                {
+                    Block_frame & frame = stack.back();
+                    size_type vertex = frame.vertex;
+                    if(frame.cursor < csr_offsets[vertex + 1])
+                    {
+                        size_type neighbour = csr_neighbours[frame.cursor++];
+                        if(!frame.parent_skipped && neighbour == stack[stack.size() - 2].vertex)
+                        {
+                            frame.parent_skipped = true;
+                            continue;
+                        }
+                        if(pre[neighbour] == 0)                                                                    // tree edge
+                        {
+                            stack.push_back(Block_frame{neighbour, csr_offsets[neighbour], false, edge_stack.size()});
+                            edge_stack.push_back(edge(std::min(vertex, neighbour), std::max(vertex, neighbour)));
+                            pre[neighbour] = low[neighbour] = ++visit_time;
+                        }
+                        else if(pre[neighbour] < pre[vertex])                                                      // back edge, each one is walked once from below
+                        {
+                            edge_stack.push_back(edge(std::min(vertex, neighbour), std::max(vertex, neighbour)));
+                            if(pre[neighbour] < low[vertex])
+                                low[vertex] = pre[neighbour];
+                        }
+                    }
+                    else
+                    {
+                        size_type block_begin = frame.tree_edge_position;
+                        stack.pop_back();
+                        if(stack.empty())
+                            break;
+                        size_type vertex_parent = stack.back().vertex;
+                        if(low[vertex] < low[vertex_parent])
+                            low[vertex_parent] = low[vertex];
+                        if(low[vertex] >= pre[vertex_parent])                                                      // vertex_parent cuts off subtree of vertex
+                        {
+                            on_block(edge_stack.data() + block_begin, edge_stack.data() + edge_stack.size());
+                            edge_stack.resize(block_begin);
+                            bool is_cut = (vertex_parent != root) || (++root_blocks > 1);
+                            if(is_cut && !is_articulation_point[vertex_parent])
+                            {
+                                is_articulation_point[vertex_parent] = true;
+                                articulation_points.push_back(vertex_parent);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /* one iteration of the ghost search: wide bridges containing ghost_id in order in which they are found, some may repeat */
+        void collectGhostBridges(size_type ghost_id, Search_scratch & scratch, std::vector<edge> & candidates) const
+        {
+            size_type num_of_search_started = 0;                                                                       // if > 1 it means that ghost disconnects graph
+            size_type root_children;                                                                                   // if > 1 root is an articulation point
+            scratch.state[ghost_id] = GHOST;
+            for(size_type v = 0; v < num_of_vertices; ++v)
+            {
+                if(scratch.vertexWasNotVisited(v))
+                {
+                    ++num_of_search_started;
+                    scratch.state[v] = VISITED;
+                    scratch.dfs_id[v] = 1;                                                                             // first visited vertex is root of the spanning tree, its id is always 1
+                    root_children = 0;
+                    for(auto neighbour : neighboursOf(v))
+                    {
+                        if(scratch.vertexWasNotVisited(neighbour))
+                        {
+                            ++root_children;
+                            DFSfindArticulationPoints(scratch, neighbour, v);
+                        }
+                    }
+
+                    if(root_children > 1)
+                        scratch.articulation_points.push_back(v);
+                }
+            }
+            if(num_of_search_started > 1)                                                                              // edges containing ghost can be wide bridges
+            {
+                for(auto neighbour : neighboursOf(ghost_id))
+                {
+                    if(degreeOf(neighbour) != 1)                                                                       // if neighbour isn't leaf of the spanning tree
+                        candidates.push_back(edge(ghost_id, neighbour));
+                }
+            }
+            for(auto a_point : scratch.articulation_points)                                                            // for each articulation point
+            {
+                for(auto neighbour : neighboursOf(ghost_id))                                                           // looking for ghost neighbours
+                {
+                    if(a_point == neighbour)                                                                           // if articulation point is neighbour then it must form with ghost a wide bridge
+                    {
+                        candidates.push_back(edge(ghost_id, a_point));
+                        break;                                                                                         // if articulation point was on neighbour list, there is no need to continue searching through that list
+                    }
+                }
+            }
+            scratch.articulation_points.clear();
+            scratch.clearAllStates();                                                                                  // reseting states to NOT_VISITED for next iteration
+        }
+
+        /* candidates of one ghost all contain it, so repeats within one iteration are filtered by a mark per vertex,
+         * the same edge found later from its other end is removed by sortEdges() */
+        static void appendGhostBridges(size_type ghost_id, const std::vector<edge> & candidates, Search_scratch & scratch, std::vector<edge> & wide_bridges)
+        {
+            for(auto candidate : candidates)
+            {
+                size_type neighbour = candidate.second;
+                if(scratch.reported_with_ghost[neighbour] == ghost_id + 1)
+                    continue;
+                scratch.reported_with_ghost[neighbour] = ghost_id + 1;
+                wide_bridges.push_back(edge(std::min(ghost_id, neighbour), std::max(ghost_id, neighbour)));
+            }
+        }
+
+        static void sortEdges(std::vector<edge> & edges)
+        {
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        }
+
+        std::vector<edge> findWideBridgesByGhosts() const
+        {
+            std::vector<edge> wide_bridges, candidates;
+            Search_scratch scratch(num_of_vertices);
+            for(size_type ghost_id = 0; ghost_id < num_of_vertices; ghost_id++)                                        // choosing ghost for one iteration
+            {
+                candidates.clear();
+                collectGhostBridges(ghost_id, scratch, candidates);
+                appendGhostBridges(ghost_id, candidates, scratch, wide_bridges);
+            }
+            sortEdges(wide_bridges);
+            return wide_bridges;
+        }
+
+        /* ghost iterations are independent, every thread has its own scratch arrays and result list, lists are merged at the end */
+        std::vector<edge> findWideBridgesByGhostsInParallel(size_type num_of_threads) const
         {
-            for(size_type i = 0; i < vertices_amount; ++i)
-                vector_of_vertices[i].vertex_id = i;
+            if(num_of_threads == 0)
+                num_of_threads = std::max(1u, std::thread::hardware_concurrency());
+            num_of_threads = std::max<size_type>(1, std::min(num_of_threads, num_of_vertices));
+            Ghost_scheduler scheduler(num_of_vertices, num_of_threads);
+            std::vector<std::vector<edge>> found(num_of_threads);
+
+            auto worker = [this, &scheduler, &found](size_type worker_id)
+            {
+                Search_scratch scratch(num_of_vertices);
+                std::vector<edge> candidates;
+                size_type ghost_id;
+                while(scheduler.takeGhost(worker_id, ghost_id))
+                {
+                    candidates.clear();
+                    collectGhostBridges(ghost_id, scratch, candidates);
+                    appendGhostBridges(ghost_id, candidates, scratch, found[worker_id]);
+                }
+            };
+            std::vector<std::thread> threads;
+            for(size_type worker_id = 1; worker_id < num_of_threads; ++worker_id)
+                threads.emplace_back(worker, worker_id);
+            worker(0);
+            for(auto & thread : threads)
+                thread.join();
+
+            std::vector<edge> wide_bridges;
+            for(const auto & worker_bridges : found)
+                wide_bridges.insert(wide_bridges.end(), worker_bridges.begin(), worker_bridges.end());
+            sortEdges(wide_bridges);
+            return wide_bridges;
         }
 
+        /* linear engine */
+
+        struct Edge_query                                                      // edge (a, b) where a is an ancestor of b in the spanning tree
+        {
+            size_type a;
+            size_type b;
+            size_type c;                                                       // child of a on the tree path down to b, c == b for tree edges
+            bool middle_reaches_above;                                         // subtree(c) without subtree(b) has a back edge above a
+        };
+
+        class Fenwick_tree                                                     // counts back edges by preorder number of their lower end
+        {
+            std::vector<size_type> tree;
+
+            size_type prefix(size_type position) const                         // sum over [1, position]
+            {
+                size_type sum = 0;
+                for(; position > 0; position -= position & (~position + 1))
+                    sum += tree[position];
+                return sum;
+            }
+
+        public:
+            explicit Fenwick_tree(size_type size) : tree(size + 1, 0) {}
+
+            void add(size_type position)
+            {
+                for(; position < tree.size(); position += position & (~position + 1))
+                    ++tree[position];
+            }
+
+            size_type range(size_type from, size_type to) const                // sum over [from, to)
+            {
+                return prefix(to - 1) - prefix(from - 1);
+            }
+        };
+
+        /* stable counting sort, returns indexes of keys grouped by key, group k is order[offsets[k]] .. order[offsets[k + 1] - 1] */
+        static std::vector<size_type> groupByKey(const std::vector<size_type> & keys, size_type key_limit, std::vector<size_type> & offsets)
+        {
+            offsets.assign(key_limit + 1, 0);
+            for(auto key : keys)
+                ++offsets[key + 1];
+            for(size_type k = 0; k < key_limit; ++k)
+                offsets[k + 1] += offsets[k];
+            std::vector<size_type> order(keys.size());
+            std::vector<size_type> cursor(offsets.begin(), offsets.end() - 1);
+            for(size_type i = 0; i < keys.size(); ++i)
+                order[cursor[keys[i]]++] = i;
+            return order;
+        }
+
+        /* Every edge of a DFS spanning tree connects an ancestor a with a descendant b. After removing a and b what is left falls into pieces:
+         * -> the part above a (empty if a is the root), with every other child subtree of a that has a back edge above a hanging on it
+         * -> other child subtrees of a without such back edge (or all of them if a is the root), each one is separate
+         * -> the middle part: subtree of c (child of a leading to b) without subtree of b, empty for tree edges
+         * -> child subtrees of b, each one joins the part above a (low < pre[a]), the middle part (high > pre[a]) or stays separate
+         * low is the smallest preorder number reachable by a back edge from a subtree, high is the largest one among proper ancestors
+         * of the parent, so both are known after one DFS and one pass of path painting. The middle part reaching above a is answered
+         * offline with a Fenwick tree. Edge is a wide bridge if at least two pieces (counting other connected components) are left. */
+        std::vector<edge> findWideBridgesLinear() const
+        {
+            const size_type no_vertex = num_of_vertices;
+            std::vector<edge> wide_bridges;
+            std::vector<size_type> pre(num_of_vertices, 0), subtree_end(num_of_vertices, 0), depth(num_of_vertices, 0);
+            std::vector<size_type> parent(num_of_vertices, no_vertex), low(num_of_vertices, 0), high(num_of_vertices, 0);
+            std::vector<size_type> children(num_of_vertices, 0), lonely_children(num_of_vertices, 0);   // lonely child has no back edge above its parent
+            std::vector<size_type> back_edge_from, back_edge_to;
+            std::vector<Edge_query> queries;
+            std::vector<Dfs_frame> stack;
+            size_type visit_time = 0, num_of_components = 0;
+
+            for(size_type root = 0; root < num_of_vertices; ++root)
+            {
+                if(pre[root] != 0)
+                    continue;
+                ++num_of_components;
+                pre[root] = low[root] = ++visit_time;
+                stack.push_back(Dfs_frame{root, csr_offsets[root]});
+                while(!stack.empty())
+                {
+                    size_type vertex = stack.back().vertex;
+                    if(stack.back().cursor < csr_offsets[vertex + 1])
+                    {
+                        size_type neighbour = csr_neighbours[stack.back().cursor++];
+                        if(pre[neighbour] == 0)                                                                // tree edge
+                        {
+                            parent[neighbour] = vertex;
+                            depth[neighbour] = depth[vertex] + 1;
+                            pre[neighbour] = low[neighbour] = ++visit_time;
+                            queries.push_back(Edge_query{vertex, neighbour, neighbour, false});
+                            stack.push_back(Dfs_frame{neighbour, csr_offsets[neighbour]});
+                        }
+                        else if(neighbour != parent[vertex] && pre[neighbour] < pre[vertex])                 // back edge, stack holds the whole tree path
+                        {
+                            queries.push_back(Edge_query{neighbour, vertex, stack[depth[neighbour] + 1].vertex, false});
+                            back_edge_from.push_back(vertex);
+                            back_edge_to.push_back(neighbour);
+                            if(pre[neighbour] < low[vertex])
+                                low[vertex] = pre[neighbour];
+                        }
+                    }
+                    else
+                    {
+                        subtree_end[vertex] = visit_time + 1;                                                  // subtree is [pre, subtree_end)
+                        stack.pop_back();
+                        size_type vertex_parent = parent[vertex];
+                        if(vertex_parent != no_vertex)
+                        {
+                            ++children[vertex_parent];
+                            if(low[vertex] >= pre[vertex_parent])
+                                ++lonely_children[vertex_parent];
+                            if(low[vertex] < low[vertex_parent])
+                                low[vertex_parent] = low[vertex];
+                        }
+                    }
+                }
+            }
+
+            std::vector<size_type> back_edge_keys(back_edge_to.size()), edge_offsets;
+            for(size_type i = 0; i < back_edge_to.size(); ++i)
+                back_edge_keys[i] = pre[back_edge_to[i]];
+            std::vector<size_type> edges_by_upper_end = groupByKey(back_edge_keys, visit_time + 1, edge_offsets);
+
+            /* high: back edges taken from the deepest upper end paint the tree path above their lower end, painted vertices are skipped */
+            std::vector<size_type> skip(num_of_vertices);
+            for(size_type v = 0; v < num_of_vertices; ++v)
+                skip[v] = v;
+            auto findUnpainted = [&skip](size_type v)
+            {
+                size_type first = v;
+                while(skip[first] != first)
+                    first = skip[first];
+                while(skip[v] != first)
+                {
+                    size_type next = skip[v];
+                    skip[v] = first;
+                    v = next;
+                }
+                return first;
+            };
+            for(size_type time = visit_time; time > 0; --time)
+            {
+                for(size_type i = edge_offsets[time]; i < edge_offsets[time + 1]; ++i)
+                {
+                    size_type upper_end = back_edge_to[edges_by_upper_end[i]];
+                    size_type v = findUnpainted(back_edge_from[edges_by_upper_end[i]]);
+                    while(depth[v] >= depth[upper_end] + 2)
+                    {
+                        high[v] = time;
+                        skip[v] = parent[v];
+                        v = findUnpainted(parent[v]);
+                    }
+                }
+            }
+
+            /* does the middle part have a back edge above a: count back edges going above a from subtree(c) and from subtree(b) */
+            std::vector<size_type> query_keys(queries.size()), query_offsets;
+            for(size_type i = 0; i < queries.size(); ++i)
+                query_keys[i] = pre[queries[i].a];
+            std::vector<size_type> queries_by_a = groupByKey(query_keys, visit_time + 1, query_offsets);
+            Fenwick_tree edges_above(visit_time);
+            for(size_type time = 1; time <= visit_time; ++time)
+            {
+                for(size_type i = query_offsets[time]; i < query_offsets[time + 1]; ++i)
+                {
+                    Edge_query & query = queries[queries_by_a[i]];
+                    if(query.c != query.b && parent[query.a] != no_vertex)
+                        query.middle_reaches_above = edges_above.range(pre[query.c], subtree_end[query.c]) >
+                                                     edges_above.range(pre[query.b], subtree_end[query.b]);
+                }
+                for(size_type i = edge_offsets[time]; i < edge_offsets[time + 1]; ++i)
+                    edges_above.add(pre[back_edge_from[edges_by_upper_end[i]]]);
+            }
+
+            std::vector<size_type> parent_keys(num_of_vertices), children_offsets;
+            for(size_type v = 0; v < num_of_vertices; ++v)
+                parent_keys[v] = (parent[v] == no_vertex) ? num_of_vertices : parent[v];
+            std::vector<size_type> children_of = groupByKey(parent_keys, num_of_vertices + 1, children_offsets);
+            for(size_type i = 0; i < queries.size(); ++i)
+                query_keys[i] = queries[i].b;
+            std::vector<size_type> queries_by_b = groupByKey(query_keys, num_of_vertices, query_offsets);
+
+            std::vector<size_type> single_target_children(visit_time + 1, 0);                                // children whose only back edge target above b is one vertex
+            std::vector<edge> spans;                                                                         // (low, high) of children reaching two places above b
+            for(size_type b = 0; b < num_of_vertices; ++b)
+            {
+                if(query_offsets[b] == query_offsets[b + 1])
+                    continue;
+                spans.clear();
+                for(size_type i = children_offsets[b]; i < children_offsets[b + 1]; ++i)
+                {
+                    size_type child = children_of[i];
+                    if(low[child] < pre[b] && high[child] == low[child])
+                        ++single_target_children[low[child]];
+                    else if(low[child] < high[child])
+                        spans.push_back(edge(low[child], high[child]));
+                }
+                std::sort(spans.begin(), spans.end());
+                for(size_type i = 1; i < spans.size(); ++i)                                                   // second becomes running maximum of high
+                    spans[i].second = std::max(spans[i].second, spans[i - 1].second);
+
+                for(size_type i = query_offsets[b]; i < query_offsets[b + 1]; ++i)
+                {
+                    const Edge_query & query = queries[queries_by_b[i]];
+                    size_type a = query.a;
+                    size_type pieces = (num_of_components - 1) + lonely_children[b] + single_target_children[pre[a]];
+                    if(parent[a] == no_vertex)
+                        pieces += children[a] - 1;
+                    else
+                        pieces += lonely_children[a] - ((low[query.c] >= pre[a]) ? 1 : 0);
+                    bool has_above = parent[a] != no_vertex;
+                    bool has_middle = query.c != b;
+                    if(has_above && has_middle)
+                    {
+                        bool joined = query.middle_reaches_above;
+                        auto span = std::lower_bound(spans.begin(), spans.end(), edge(pre[a], 0));          // first span with low >= pre[a]
+                        if(!joined && span != spans.begin() && (span - 1)->second > pre[a])
+                            joined = true;
+                        pieces += joined ? 1 : 2;
+                    }
+                    else if(has_above || has_middle)
+                        ++pieces;
+                    if(pieces >= 2)
+                        wide_bridges.push_back(edge(std::min(a, b), std::max(a, b)));
+                }
+
+                for(size_type i = children_offsets[b]; i < children_offsets[b + 1]; ++i)
+                    single_target_children[low[children_of[i]]] = 0;
+            }
+            sortEdges(wide_bridges);
+            return wide_bridges;
+        }
+
+
+    public:
+        Graph(size_type vertices_amount) : num_of_vertices(vertices_amount)
+        {}
+
         void createEdge(size_type v, size_type u)
         {
-            vector_of_vertices[v].setAdjacentTo(u);
-            vector_of_vertices[u].setAdjacentTo(v);
+            if(snapshot)
+                throw std::logic_error("in function: createEdge(), graph mapped from snapshot is read-only");
+            created_edges.push_back(edge(v, u));
+            adjacency_is_frozen = false;                                       // adjacency arrays are rebuilt before next search
+        }
+
+        void reserveEdges(size_type edges_amount)
+        {
+            created_edges.reserve(edges_amount);
+        }
+
+        size_type getNumOfVertices() const
+        {
+            return num_of_vertices;
+        }
+
+        /* every edge once, as (smaller, bigger), works for mapped snapshots too */
+        std::vector<edge> getEdges()
+        {
+            freezeAdjacency();
+            std::vector<edge> edges;
+            edges.reserve(csr_offsets[num_of_vertices] / 2);
+            for(size_type v = 0; v < num_of_vertices; ++v)
+            {
+                for(auto neighbour : neighboursOf(v))
+                {
+                    if(v < neighbour)
+                        edges.push_back(edge(v, neighbour));
+                }
+            }
+            return edges;
+        }
+
+        /* writes frozen adjacency arrays, so mapSnapshot() can later use them without parsing or copying */
+        void writeSnapshot(const std::string & path)
+        {
+            freezeAdjacency();
+            Snapshot_header header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.magic, snapshotMagic(), sizeof(header.magic));
+            header.version = SNAPSHOT_VERSION;
+            header.word_size = sizeof(size_type);
+            header.byte_order_mark = BYTE_ORDER_MARK;
+            header.num_of_vertices = num_of_vertices;
+            header.num_of_adjacent = csr_offsets[num_of_vertices];
+
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(csr_offsets), (num_of_vertices + 1) * sizeof(size_type));
+            file.write(reinterpret_cast<const char*>(csr_neighbours), header.num_of_adjacent * sizeof(size_type));
+            if(!file.flush())
+                throw std::runtime_error("in function: writeSnapshot(), cannot write " + path);
+        }
+
+        /* one linear pass over mapped arrays: offsets start at 0, never decrease and end at num_of_adjacent,
+         * every neighbour is an existing vertex, so no search can read outside the mapping */
+        static bool isValidAdjacency(const size_type* offsets, const size_type* neighbours, std::uint64_t vertices, std::uint64_t adjacent)
+        {
+            if(offsets[0] != 0 || offsets[vertices] != adjacent)
+                return false;
+            for(std::uint64_t v = 0; v < vertices; ++v)
+                if(offsets[v] > offsets[v + 1])
+                    return false;
+            for(std::uint64_t i = 0; i < adjacent; ++i)
+                if(neighbours[i] >= vertices)
+                    return false;
+            return true;
+        }
+
+        /* maps snapshot read-only, it is checked once in linear time, then searches read it in place without copying */
+        static Graph mapSnapshot(const std::string & path)
+        {
+            int file_descriptor = ::open(path.c_str(), O_RDONLY);
+            if(file_descriptor < 0)
+                throw std::runtime_error("in function: mapSnapshot(), cannot open " + path);
+            struct stat file_info;
+            void* mapping = MAP_FAILED;
+            if(::fstat(file_descriptor, &file_info) == 0 && static_cast<std::uint64_t>(file_info.st_size) >= sizeof(Snapshot_header))
+                mapping = ::mmap(nullptr, file_info.st_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+            ::close(file_descriptor);
+            if(mapping == MAP_FAILED)
+                throw std::runtime_error("in function: mapSnapshot(), cannot map " + path);
+            size_type mapping_size = file_info.st_size;
+            std::shared_ptr<const void> snapshot_mapping(mapping, [mapping_size](const void* address)
+            {
+                ::munmap(const_cast<void*>(address), mapping_size);
+            });
+
+            const Snapshot_header* header = static_cast<const Snapshot_header*>(mapping);
+            if(std::memcmp(header->magic, snapshotMagic(), sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION ||
+               header->word_size != sizeof(size_type) || header->byte_order_mark != BYTE_ORDER_MARK)
+                throw std::runtime_error("in function: mapSnapshot(), unsupported snapshot format in " + path);
+            /* counts come from the file, so they are compared with its length before any arithmetic that could overflow */
+            std::uint64_t words = (mapping_size - sizeof(Snapshot_header)) / sizeof(size_type);
+            if((mapping_size - sizeof(Snapshot_header)) % sizeof(size_type) != 0 || header->num_of_vertices >= words ||
+               header->num_of_adjacent != words - header->num_of_vertices - 1)
+                throw std::runtime_error("in function: mapSnapshot(), truncated snapshot " + path);
+
+            const size_type* offsets = reinterpret_cast<const size_type*>(header + 1);
+            const size_type* neighbours = offsets + header->num_of_vertices + 1;
+            if(!isValidAdjacency(offsets, neighbours, header->num_of_vertices, header->num_of_adjacent))
+                throw std::runtime_error("in function: mapSnapshot(), corrupt snapshot " + path);
+
+            Graph G(header->num_of_vertices);
+            G.csr_offsets = offsets;
+            G.csr_neighbours = neighbours;
+            G.snapshot = std::move(snapshot_mapping);
+            G.adjacency_is_frozen = true;
+            return G;
         }
 
         /* for vertex to be an articulation point, one of the following must happen:
@@ -119,78 +836,73 @@ namespace aisdi
          *      Liczba składowych grafu wzrośnie, zatem ojciec musi być punktem artykulacji.*/
 
 
-        std::vector<edge> findWideBridges()
+        /* vertices whose removal increases the number of connected components, sorted */
+        std::vector<size_type> findArticulationPoints()
         {
-            std::vector<edge> wide_bridges;
+            freezeAdjacency();
             std::vector<size_type> articulation_points;
-            size_type num_of_search_started = 0;                                                                       // if > 1 it means that ghost disconnects graph
-            size_type root_children;                                                                                   // if > 1 root is an articulation point
-            for(size_type ghost_id = 0; ghost_id < num_of_vertices; ghost_id++)                                        // choosing ghost for one iteration
+            DFSsplitIntoBlocks([](const edge*, const edge*) {}, articulation_points);
+            std::sort(articulation_points.begin(), articulation_points.end());
+            return articulation_points;
+        }
+
+        /* edges whose removal increases the number of connected components, as (smaller, bigger) in sorted order */
+        std::vector<edge> findBridges()
+        {
+            freezeAdjacency();
+            std::vector<edge> bridges;
+            std::vector<size_type> articulation_points;
+            DFSsplitIntoBlocks([&bridges](const edge* first, const edge* last)
             {
-                vector_of_vertices[ghost_id].state = GHOST;
-                for(size_type v = 0; v < num_of_vertices; ++v)
-                {
-                    if(vertexWasNotVisited(v))
-                    {
-                        ++num_of_search_started;
-                        vector_of_vertices[v].state = VISITED;
-                        vector_of_vertices[v].dfs_id = 1;                                                              // first visited vertex is root of the spanning tree, its id is always 1
-                        root_children = 0;
-                        for(auto neighbour : vector_of_vertices[v].adjacent_vertices)
-                        {
-                            if(vertexWasNotVisited(neighbour))
-                            {
-                                ++root_children;
-                                DFSfindArticulationPoints(neighbour, v, articulation_points);
-                            }
-                        }
+                if(last - first == 1)
+                    bridges.push_back(*first);
+            }, articulation_points);
+            sortEdges(bridges);
+            return bridges;
+        }
 
-                        if(root_children > 1)
-                            articulation_points.push_back(v);
-                    }
-                }
-                if(num_of_search_started > 1)                                                                          // edges containing ghost can be wide bridges
-                {
-                    for(auto neighbour : vector_of_vertices[ghost_id].adjacent_vertices)
-                    {
-                        if(vector_of_vertices[neighbour].adjacent_vertices.size() != 1)                                // if neighbour isn't leaf of the spanning tree
-                        {
-                            bool already_in = false;
-                            for(auto existing_bridge : wide_bridges)                                                   // checking if this wide bridge already exists
-                            {
-                                if((existing_bridge.first == ghost_id && existing_bridge.second == neighbour) ||
-                                   (existing_bridge.first == neighbour && existing_bridge.second == ghost_id))
-                                    already_in = true;
-                            }
-                            if(!already_in)
-                                wide_bridges.push_back(edge(ghost_id, neighbour));
-                        }
-                    }
-                }
-                for(auto a_point : articulation_points)                                                                // for each articulation point
+        /* blocks, articulation points and links between them, all from one DFS */
+        Block_cut_tree biconnectedComponents()
+        {
+            freezeAdjacency();
+            Block_cut_tree tree;
+            DFSsplitIntoBlocks([&tree](const edge* first, const edge* last)
+            {
+                tree.blocks.push_back(std::vector<edge>(first, last));
+            }, tree.articulation_points);
+            std::sort(tree.articulation_points.begin(), tree.articulation_points.end());
+
+            std::vector<size_type> linked_with(num_of_vertices, tree.blocks.size());  // last block linked with articulation point
+            std::vector<bool> is_articulation_point(num_of_vertices, false);
+            for(auto v : tree.articulation_points)
+                is_articulation_point[v] = true;
+            for(size_type block = 0; block < tree.blocks.size(); ++block)
+            {
+                for(const auto & e : tree.blocks[block])
                 {
-                    for(auto neighbour : vector_of_vertices[ghost_id].adjacent_vertices)                               // looking for ghost neighbours
+                    for(auto v : {e.first, e.second})
                     {
-                        if(a_point == neighbour)                                                                       // if articulation point is neighbour then it must form with ghost a wide bridge
+                        if(is_articulation_point[v] && linked_with[v] != block)
                         {
-                            bool already_in = false;
-                            for(auto existing_bridge : wide_bridges)
-                            {
-                                if((existing_bridge.first == ghost_id && existing_bridge.second == a_point) ||
-                                   (existing_bridge.first == a_point && existing_bridge.second == ghost_id))           // checking if this wide bridge already exists
-                                    already_in = true;
-                            }
-                            if(!already_in)
-                                wide_bridges.push_back(edge(ghost_id, a_point));
-                            break;                                                                                     // if articulation point was on neighbour list, there is no need to continue searching through that list
+                            linked_with[v] = block;
+                            tree.tree_edges.push_back(edge(block, v));
                         }
                     }
                 }
-                num_of_search_started = 0;
-                articulation_points.clear();                                                                           
-                clearAllStates();                                                                                      // reseting states to NOT_VISITED for next iteration
             }
-            return wide_bridges;
+            return tree;
+        }
+
+        /* every mode returns edges as (smaller, bigger) in sorted order, so results of different modes can be compared directly
+         * num_of_threads is used only by PARALLEL_GHOST_SEARCH, 0 means one per hardware thread */
+        std::vector<edge> findWideBridges(Wide_bridges_mode mode = LINEAR_SEARCH, size_type num_of_threads = 0)
+        {
+            freezeAdjacency();
+            if(mode == LINEAR_SEARCH)
+                return findWideBridgesLinear();
+            if(mode == PARALLEL_GHOST_SEARCH)
+                return findWideBridgesByGhostsInParallel(num_of_threads);
+            return findWideBridgesByGhosts();
         }
     };
 }// namespace
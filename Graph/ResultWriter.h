@@ -0,0 +1,113 @@
+#ifndef AISDI_RESULT_WRITER_H
+#define AISDI_RESULT_WRITER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <unistd.h>
+#include "Graph.h"
+
+
+namespace aisdi
+{
+    /* writes results (pairs of vertices) through one large buffer, handed to the system only when it is full:
+     * -> TEXT prints "v u" per line, numbers are formatted by hand
+     * -> BINARY writes each pair as two 64 bit unsigned numbers in native byte order, nothing between them */
+    class ResultWriter
+    {
+    public:
+        using size_type = Graph::size_type;
+        using edge = Graph::edge;
+
+        enum Output_format {TEXT, BINARY};
+    private:
+        static const size_type WRITE_BLOCK_SIZE = 1 << 20;
+        static const size_type MAX_PAIR_LENGTH = 2 * 20 + 2;                   // two 64 bit numbers, space and newline
+
+        int file_descriptor;
+        Output_format format;
+        std::vector<char> buffer;
+        size_type used = 0;
+
+        void writeAll(const char* data, size_type length)
+        {
+            while(length > 0)
+            {
+                ssize_t bytes_written = ::write(file_descriptor, data, length);
+                if(bytes_written < 0)
+                {
+                    if(errno == EINTR)
+                        continue;
+                    throw std::runtime_error("in ResultWriter: cannot write output");
+                }
+                data += bytes_written;
+                length -= bytes_written;
+            }
+        }
+
+        void appendNumber(size_type value)
+        {
+            char digits[20];
+            size_type length = 0;
+            do
+            {
+                digits[length++] = '0' + value % 10;
+                value /= 10;
+            } while(value != 0);
+            while(length > 0)
+                buffer[used++] = digits[--length];
+        }
+
+    public:
+        explicit ResultWriter(int file_descriptor, Output_format format = TEXT) : file_descriptor(file_descriptor), format(format),
+                                                                                  buffer(WRITE_BLOCK_SIZE)
+        {}
+
+        ResultWriter(const ResultWriter&) = delete;
+        ResultWriter& operator=(const ResultWriter&) = delete;
+
+        /* destructor can't report errors, call flush() to know that everything was written */
+        ~ResultWriter()
+        {
+            try
+            {
+                flush();
+            }
+            catch(...)
+            {}
+        }
+
+        void write(size_type v, size_type u)
+        {
+            if(buffer.size() - used < MAX_PAIR_LENGTH)
+                flush();
+            if(format == BINARY)
+            {
+                std::uint64_t pair[2] = {v, u};
+                std::memcpy(buffer.data() + used, pair, sizeof(pair));
+                used += sizeof(pair);
+                return;
+            }
+            appendNumber(v);
+            buffer[used++] = ' ';
+            appendNumber(u);
+            buffer[used++] = '\n';
+        }
+
+        void write(const std::vector<edge> & edges)
+        {
+            for(const auto & e : edges)
+                write(e.first, e.second);
+        }
+
+        void flush()
+        {
+            size_type length = used;
+            used = 0;
+            writeAll(buffer.data(), length);
+        }
+    };
+}// namespace
+#endif
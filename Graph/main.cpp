@@ -1,27 +1,44 @@
+#include <string>
 #include <iostream>
+#include <exception>
+#include <unistd.h>
 #include "Graph.h"
+#include "EdgeListLoader.h"
+#include "ResultWriter.h"
 
 
-int main()
+/* ./program < graph.txt                                  - reads edge list, prints wide bridges
+ * ./program --write-snapshot graph.bin < graph.txt       - reads edge list, saves it as binary snapshot
+ * ./program --snapshot graph.bin                         - maps binary snapshot, prints wide bridges
+ * --binary given as the last argument writes wide bridges as pairs of 64 bit numbers instead of text */
+int main(int argc, char* argv[])
 {
-    size_t num_of_vertices, v, u;
+    bool binary_output = (argc > 1) && std::string(argv[argc - 1]) == "--binary";
+    if(binary_output)
+        --argc;
+    std::string option = (argc > 2) ? argv[1] : "";
 
-    std::cin >> num_of_vertices;
+    try
+    {
+        aisdi::Graph G = (option == "--snapshot") ? aisdi::Graph::mapSnapshot(argv[2]) : aisdi::EdgeListLoader(STDIN_FILENO).load();
 
-    aisdi::Graph G(num_of_vertices);
+        if(option == "--write-snapshot")
+        {
+            G.writeSnapshot(argv[2]);
+            return 0;
+        }
 
-    while(std::cin >> v)
-    {
-        std::cin >> u;
-        G.createEdge(v, u);
-    }
+        std::vector<std::pair<size_t, size_t>> result = G.findWideBridges();
 
-    std::vector<std::pair<size_t, size_t>> result = G.findWideBridges();
-    
-    for(auto x: result)
+        aisdi::ResultWriter output(STDOUT_FILENO, binary_output ? aisdi::ResultWriter::BINARY : aisdi::ResultWriter::TEXT);
+        output.write(result);
+        output.flush();
+    }
+    catch(const std::exception& e)                                             // corrupt snapshot, unreadable input or output
     {
-        std::cout << x.first << " " << x.second << std:: endl;
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
     return 0;
-}
\ No newline at end of file
+}
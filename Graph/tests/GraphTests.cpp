@@ -0,0 +1,176 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "../Graph.h"
+
+namespace
+{
+    using size_type = aisdi::Graph::size_type;
+    using edge = aisdi::Graph::edge;
+
+    edge normalised(size_type v, size_type u)
+    {
+        return (v < u) ? edge(v, u) : edge(u, v);
+    }
+
+    /* connected components of the graph made of edges, without vertex skipped and without edge number skipped_edge */
+    size_type countComponents(size_type vertices, const std::vector<edge> & edges, size_type skipped = SIZE_MAX, size_type skipped_edge = SIZE_MAX)
+    {
+        std::vector<size_type> parent(vertices);
+        for(size_type v = 0; v < vertices; ++v)
+            parent[v] = v;
+        auto root = [&parent](size_type v)
+        {
+            while(parent[v] != v)
+                v = parent[v] = parent[parent[v]];
+            return v;
+        };
+        size_type components = (skipped < vertices) ? vertices - 1 : vertices;
+        for(size_type i = 0; i < edges.size(); ++i)
+        {
+            if(i == skipped_edge || edges[i].first == skipped || edges[i].second == skipped)
+                continue;
+            size_type a = root(edges[i].first), b = root(edges[i].second);
+            if(a != b)
+            {
+                parent[a] = b;
+                --components;
+            }
+        }
+        return components;
+    }
+
+    /* removing an articulation point leaves more components than the graph had, not counting the point itself if it was isolated */
+    std::vector<size_type> bruteArticulationPoints(size_type vertices, const std::vector<edge> & edges)
+    {
+        size_type components = countComponents(vertices, edges);
+        std::vector<size_type> points;
+        for(size_type v = 0; v < vertices; ++v)
+        {
+            bool isolated = true;
+            for(const auto & e : edges)
+                if(e.first == v || e.second == v)
+                    isolated = false;
+            if(countComponents(vertices, edges, v) > components - (isolated ? 1 : 0))
+                points.push_back(v);
+        }
+        return points;
+    }
+
+    /* a bridge is an edge whose one copy removed splits a component, so parallel edges are never bridges */
+    std::vector<edge> bruteBridges(size_type vertices, const std::vector<edge> & edges)
+    {
+        size_type components = countComponents(vertices, edges);
+        std::set<edge> bridges;
+        for(size_type i = 0; i < edges.size(); ++i)
+            if(countComponents(vertices, edges, SIZE_MAX, i) > components)
+                bridges.insert(normalised(edges[i].first, edges[i].second));
+        return std::vector<edge>(bridges.begin(), bridges.end());
+    }
+
+    /* blocks split the edges, each block is connected with no articulation point of its own, and two blocks meet
+     * only in one vertex, an articulation point of the graph, which together means the blocks are maximal */
+    void checkBlockCutTree(size_type vertices, const std::vector<edge> & edges, const aisdi::Graph::Block_cut_tree & tree,
+                           const std::vector<size_type> & articulation_points)
+    {
+        assert(tree.articulation_points == articulation_points);
+        std::multiset<edge> all_edges, block_edges;
+        for(const auto & e : edges)
+            all_edges.insert(normalised(e.first, e.second));
+        std::vector<std::set<size_type>> block_vertices(tree.blocks.size());
+        for(size_type block = 0; block < tree.blocks.size(); ++block)
+        {
+            assert(!tree.blocks[block].empty());
+            for(const auto & e : tree.blocks[block])
+            {
+                assert(e.first < e.second);
+                block_edges.insert(e);
+                block_vertices[block].insert(e.first);
+                block_vertices[block].insert(e.second);
+            }
+            assert(countComponents(vertices, tree.blocks[block]) == vertices - block_vertices[block].size() + 1);
+            for(auto v : bruteArticulationPoints(vertices, tree.blocks[block]))
+                assert(block_vertices[block].count(v) == 0);
+        }
+        assert(block_edges == all_edges);
+
+        std::set<size_type> is_articulation_point(articulation_points.begin(), articulation_points.end());
+        std::set<edge> expected_tree_edges;
+        for(size_type first = 0; first < tree.blocks.size(); ++first)
+        {
+            for(auto v : block_vertices[first])
+                if(is_articulation_point.count(v) != 0)
+                    expected_tree_edges.insert(edge(first, v));
+            for(size_type second = first + 1; second < tree.blocks.size(); ++second)
+            {
+                size_type shared = 0;
+                for(auto v : block_vertices[first])
+                {
+                    if(block_vertices[second].count(v) != 0)
+                    {
+                        assert(is_articulation_point.count(v) != 0);
+                        ++shared;
+                    }
+                }
+                assert(shared <= 1);
+            }
+        }
+        std::set<edge> tree_edges(tree.tree_edges.begin(), tree.tree_edges.end());
+        assert(tree_edges.size() == tree.tree_edges.size());
+        assert(tree_edges == expected_tree_edges);
+    }
+
+    /* small random graphs, sparse and dense, with parallel edges and isolated vertices, against brute force */
+    void blocksMatchBruteForce()
+    {
+        std::mt19937 random(9);
+        for(int round = 0; round < 3000; ++round)
+        {
+            size_type vertices = 1 + random() % 10;
+            size_type edges_amount = random() % (2 * vertices + 2);
+            std::vector<edge> edges;
+            aisdi::Graph G(vertices);
+            for(size_type i = 0; i < edges_amount && vertices > 1; ++i)
+            {
+                size_type v = random() % vertices, u = random() % vertices;
+                if(v == u)
+                    continue;
+                edges.push_back(edge(v, u));
+                G.createEdge(v, u);
+            }
+            std::vector<size_type> articulation_points = bruteArticulationPoints(vertices, edges);
+            assert(G.findArticulationPoints() == articulation_points);
+            assert(G.findBridges() == bruteBridges(vertices, edges));
+            checkBlockCutTree(vertices, edges, G.biconnectedComponents(), articulation_points);
+        }
+    }
+
+    /* two triangles joined by a path: 2 and 3 and 4 are articulation points, (2, 3) and (3, 4) are bridges */
+    void twoTrianglesJoinedByPath()
+    {
+        aisdi::Graph G(7);
+        std::vector<edge> edges = {{0, 1}, {1, 2}, {2, 0}, {2, 3}, {3, 4}, {4, 5}, {5, 6}, {6, 4}};
+        for(const auto & e : edges)
+            G.createEdge(e.first, e.second);
+        assert(G.findArticulationPoints() == std::vector<size_type>({2, 3, 4}));
+        assert(G.findBridges() == std::vector<edge>({{2, 3}, {3, 4}}));
+        aisdi::Graph::Block_cut_tree tree = G.biconnectedComponents();
+        assert(tree.blocks.size() == 4);
+        assert(tree.tree_edges.size() == 6);
+        checkBlockCutTree(7, edges, tree, {2, 3, 4});
+    }
+}
+
+int main()
+{
+    twoTrianglesJoinedByPath();
+    blocksMatchBruteForce();
+    std::cout << "Graph tests passed" << std::endl;
+    return 0;
+}
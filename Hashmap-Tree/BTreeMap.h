@@ -0,0 +1,1230 @@
+#ifndef AISDI_MAPS_BTREEMAP_H
+#define AISDI_MAPS_BTREEMAP_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
+#include <tuple>
+#include <memory>
+#include <iterator>
+#include <new>
+
+#include "TransparentLookup.h"
+
+namespace aisdi
+{
+
+/* ordered map with the interface of TreeMap except select() and rank(), which would need subtree sizes in inner nodes;
+ * kept as a B+ tree: inner nodes hold only separator keys and children, elements live in leaves chained into a list,
+ * so in-order iteration, bounds and ranges walk leaves one after another
+ * nodes take a few cache lines and keep their keys in one contiguous array, searched by a binary search without
+ * branches; leaves keep a copy of every key next to the elements for the same reason
+ * inserting or removing an element moves other elements of its leaf, so it invalidates iterators;
+ * moving keys and values must not throw */
+template <typename KeyType, typename ValueType>
+class BTreeMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+private:
+  static constexpr size_type NODE_BYTES = 256;
+  static constexpr size_type LEAF_CAPACITY = (NODE_BYTES / sizeof(value_type) > 4) ? NODE_BYTES / sizeof(value_type) : 4;
+  static constexpr size_type INNER_CAPACITY = (NODE_BYTES / (sizeof(key_type) + sizeof(void*)) > 4) ? NODE_BYTES / (sizeof(key_type) + sizeof(void*)) : 4;
+  static constexpr size_type MIN_LEAF_COUNT = LEAF_CAPACITY / 2;         // below it a node takes from or merges with a sibling,
+  static constexpr size_type MIN_INNER_COUNT = INNER_CAPACITY / 2;       // only the right edge may stay below after appending
+  static constexpr size_type MAX_DEPTH = 64;                            // inner levels, at least doubling the size each
+
+  struct Node
+  {
+    size_type count;                                                    // keys in node
+    bool isLeaf;
+
+    explicit Node(bool leaf) : count(0), isLeaf(leaf)
+    {}
+  };
+
+  struct Leaf : Node
+  {
+    Leaf* previous;
+    Leaf* next;
+    typename std::aligned_storage<sizeof(key_type), alignof(key_type)>::type keyStorage[LEAF_CAPACITY];
+    typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type valueStorage[LEAF_CAPACITY];
+
+    Leaf() : Node(true), previous(nullptr), next(nullptr)
+    {}
+
+    ~Leaf()
+    {
+      for(size_type i = 0; i < this->count; ++i)
+      {
+        keys()[i].~key_type();
+        values()[i].~value_type();
+      }
+    }
+
+    key_type* keys()
+    {
+      return reinterpret_cast<key_type*>(keyStorage);
+    }
+
+    const key_type* keys() const
+    {
+      return reinterpret_cast<const key_type*>(keyStorage);
+    }
+
+    value_type* values()
+    {
+      return reinterpret_cast<value_type*>(valueStorage);
+    }
+
+    const value_type* values() const
+    {
+      return reinterpret_cast<const value_type*>(valueStorage);
+    }
+  };
+
+  /* keys[i] is the smallest key that may be found under children[i + 1]; one spare key and child let a full node
+   * take one more before it is split */
+  struct Inner : Node
+  {
+    typename std::aligned_storage<sizeof(key_type), alignof(key_type)>::type keyStorage[INNER_CAPACITY + 1];
+    Node* children[INNER_CAPACITY + 2];
+
+    Inner() : Node(false)
+    {}
+
+    ~Inner()
+    {
+      for(size_type i = 0; i < this->count; ++i)
+        keys()[i].~key_type();
+    }
+
+    key_type* keys()
+    {
+      return reinterpret_cast<key_type*>(keyStorage);
+    }
+
+    const key_type* keys() const
+    {
+      return reinterpret_cast<const key_type*>(keyStorage);
+    }
+  };
+
+  struct PathStep
+  {
+    Inner* node;
+    size_type childIndex;
+  };
+
+  Node* root;
+  Leaf* firstLeaf;
+  Leaf* lastLeaf;
+  size_type size;
+
+  /* number of keys smaller than key, found by binary search whose steps are selected without a jump, so for simple keys
+   * the outcome of a comparison is never mispredicted */
+  template <typename LookupKey>
+  static size_type countSmaller(const key_type* keys, size_type count, const LookupKey& key)
+  {
+    size_type position = 0;
+    for(size_type length = count; length > 0;)
+    {
+      size_type half = length / 2;
+      bool greater = key > keys[position + half];
+      position += greater ? half + 1 : 0;
+      length = greater ? length - half - 1 : half;
+    }
+    return position;
+  }
+
+  /* number of keys not greater than key, the same search as countSmaller() */
+  template <typename LookupKey>
+  static size_type countNotGreater(const key_type* keys, size_type count, const LookupKey& key)
+  {
+    size_type position = 0;
+    for(size_type length = count; length > 0;)
+    {
+      size_type half = length / 2;
+      bool notLess = !(key < keys[position + half]);
+      position += notLess ? half + 1 : 0;
+      length = notLess ? length - half - 1 : half;
+    }
+    return position;
+  }
+
+  /* index of the child that may hold key */
+  template <typename LookupKey>
+  static size_type childPosition(const Inner* inner, const LookupKey& key)
+  {
+    return countNotGreater(inner->keys(), inner->count, key);
+  }
+
+  /* elements from .. count - 1 go one place right, from is left without an object */
+  template <typename T>
+  static void shiftRight(T* array, size_type from, size_type count)
+  {
+    for(size_type i = count; i > from; --i)
+    {
+      ::new (static_cast<void*>(array + i)) T(std::move(array[i - 1]));
+      array[i - 1].~T();
+    }
+  }
+
+  /* from has no object, elements from + 1 .. count - 1 go one place left */
+  template <typename T>
+  static void shiftLeft(T* array, size_type from, size_type count)
+  {
+    for(size_type i = from; i + 1 < count; ++i)
+    {
+      ::new (static_cast<void*>(array + i)) T(std::move(array[i + 1]));
+      array[i + 1].~T();
+    }
+  }
+
+  template <typename T>
+  static void moveObjects(T* from, size_type amount, T* to)
+  {
+    for(size_type i = 0; i < amount; ++i)
+    {
+      ::new (static_cast<void*>(to + i)) T(std::move(from[i]));
+      from[i].~T();
+    }
+  }
+
+  static void destroySubtree(Node* node)
+  {
+    if(node->isLeaf)
+    {
+      delete static_cast<Leaf*>(node);
+      return;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    for(size_type i = 0; i <= inner->count; ++i)
+      destroySubtree(inner->children[i]);
+    delete inner;
+  }
+
+  void clearTree()
+  {
+    if(root != nullptr)
+      destroySubtree(root);
+    root = nullptr;
+    firstLeaf = lastLeaf = nullptr;
+    size = 0;
+  }
+
+  /* asks for all cache lines of a node at once, so the binary search over it doesn't wait for them one after another */
+  template <typename NodeType>
+  static void prefetchNode(const NodeType* node)
+  {
+#if defined(__GNUC__)
+    for(size_type offset = 0; offset < sizeof(NodeType); offset += 64)
+      __builtin_prefetch(reinterpret_cast<const char*>(node) + offset);
+#else
+    (void)node;
+#endif
+  }
+
+  template <typename LookupKey>
+  Leaf* findLeaf(const LookupKey& key) const
+  {
+    Node* node = root;
+    while(!node->isLeaf)
+    {
+      Inner* inner = static_cast<Inner*>(node);
+      prefetchNode(inner);
+      node = inner->children[childPosition(inner, key)];
+    }
+    prefetchNode(static_cast<Leaf*>(node));
+    return static_cast<Leaf*>(node);
+  }
+
+  /* same as findLeaf(), inner nodes on the way and children taken from them are written to path */
+  template <typename LookupKey>
+  Leaf* descend(const LookupKey& key, PathStep* path, size_type& depth) const
+  {
+    depth = 0;
+    Node* node = root;
+    while(!node->isLeaf)
+    {
+      Inner* inner = static_cast<Inner*>(node);
+      size_type index = childPosition(inner, key);
+      path[depth++] = PathStep{inner, index};
+      node = inner->children[index];
+    }
+    return static_cast<Leaf*>(node);
+  }
+
+  /* leaf and index of key, nullptr leaf if there is no such key */
+  template <typename LookupKey>
+  std::pair<Leaf*, size_type> findElement(const LookupKey& key) const
+  {
+    if(root == nullptr)
+      return std::make_pair(nullptr, 0);
+    Leaf* leaf = findLeaf(key);
+    size_type index = countSmaller(leaf->keys(), leaf->count, key);
+    if(index == leaf->count || leaf->keys()[index] != key)
+      return std::make_pair(nullptr, 0);
+    return std::make_pair(leaf, index);
+  }
+
+  /* index past the last element of a leaf is the first element of the next one, nullptr leaf stands for end() */
+  static std::pair<Leaf*, size_type> elementAt(Leaf* leaf, size_type index)
+  {
+    if(index < leaf->count)
+      return std::make_pair(leaf, index);
+    return std::make_pair(leaf->next, 0);
+  }
+
+  /* keys of the leaf after the one findLeaf() gives are not less than the separator that led there, which is greater
+   * than key, so a bound missing from that leaf is the first element of the next one */
+  template <typename LookupKey>
+  std::pair<Leaf*, size_type> lowerBoundElement(const LookupKey& key) const
+  {
+    if(root == nullptr)
+      return std::make_pair(nullptr, 0);
+    Leaf* leaf = findLeaf(key);
+    return elementAt(leaf, countSmaller(leaf->keys(), leaf->count, key));
+  }
+
+  template <typename LookupKey>
+  std::pair<Leaf*, size_type> upperBoundElement(const LookupKey& key) const
+  {
+    if(root == nullptr)
+      return std::make_pair(nullptr, 0);
+    Leaf* leaf = findLeaf(key);
+    return elementAt(leaf, countNotGreater(leaf->keys(), leaf->count, key));
+  }
+
+  /* element with key is the lower bound, the upper bound is then the next element, so one descent is enough */
+  template <typename LookupKey>
+  std::pair<std::pair<Leaf*, size_type>, std::pair<Leaf*, size_type>> equalRangeElements(const LookupKey& key) const
+  {
+    auto lower = lowerBoundElement(key);
+    if(lower.first == nullptr || key < lower.first->keys()[lower.second])
+      return std::make_pair(lower, lower);
+    return std::make_pair(lower, elementAt(lower.first, lower.second + 1));
+  }
+
+  /* elements of [first, last), last is searched only if the range is not empty */
+  template <typename FirstKey, typename LastKey>
+  std::pair<std::pair<Leaf*, size_type>, std::pair<Leaf*, size_type>> rangeElements(const FirstKey& first, const LastKey& last) const
+  {
+    auto begin = lowerBoundElement(first);
+    if(begin.first == nullptr || !(last > begin.first->keys()[begin.second]))
+      return std::make_pair(begin, begin);
+    return std::make_pair(begin, lowerBoundElement(last));
+  }
+
+  /* splits full leaf in halves, and every full inner node above it; new nodes and the separator copy are made first,
+   * so if that throws the tree is untouched, the rest only moves objects; returns the new right half
+   * when keys are appended after the last one, nodes on the right edge are split leaving only the last element
+   * (or key) to the new node, so growing in order fills the tree almost completely instead of by half */
+  Leaf* splitLeaf(Leaf* leaf, PathStep* path, size_type depth, bool appending)
+  {
+    size_type fullAncestors = 0;
+    while(fullAncestors < depth && path[depth - 1 - fullAncestors].node->count == INNER_CAPACITY)
+      ++fullAncestors;
+    std::unique_ptr<Inner> newInners[MAX_DEPTH + 1];
+    size_type innersNeeded = (fullAncestors == depth) ? fullAncestors + 1 : fullAncestors;
+    for(size_type i = 0; i < innersNeeded; ++i)
+      newInners[i].reset(new Inner());
+    std::unique_ptr<Leaf> newLeaf(new Leaf());
+    size_type half = appending ? leaf->count - 1 : leaf->count / 2;
+    key_type separator(leaf->keys()[half]);
+
+    Leaf* right = newLeaf.release();
+    moveObjects(leaf->keys() + half, leaf->count - half, right->keys());
+    moveObjects(leaf->values() + half, leaf->count - half, right->values());
+    right->count = leaf->count - half;
+    leaf->count = half;
+    right->previous = leaf;
+    right->next = leaf->next;
+    if(leaf->next != nullptr)
+      leaf->next->previous = right;
+    else
+      lastLeaf = right;
+    leaf->next = right;
+
+    Node* child = right;
+    size_type used = 0;
+    for(size_type level = depth; ; --level)
+    {
+      if(level == 0)
+      {
+        Inner* newRoot = newInners[used++].release();
+        ::new (static_cast<void*>(newRoot->keys())) key_type(std::move(separator));
+        newRoot->children[0] = root;
+        newRoot->children[1] = child;
+        newRoot->count = 1;
+        root = newRoot;
+        break;
+      }
+      Inner* parent = path[level - 1].node;
+      size_type index = path[level - 1].childIndex;
+      shiftRight(parent->keys(), index, parent->count);
+      ::new (static_cast<void*>(parent->keys() + index)) key_type(std::move(separator));
+      shiftRight(parent->children, index + 1, parent->count + 1);
+      parent->children[index + 1] = child;
+      if(++parent->count <= INNER_CAPACITY)
+        break;
+      Inner* sibling = newInners[used++].release();
+      size_type middle = (appending && index == INNER_CAPACITY) ? parent->count - 2 : parent->count / 2;
+      separator = std::move(parent->keys()[middle]);
+      parent->keys()[middle].~key_type();
+      moveObjects(parent->keys() + middle + 1, parent->count - middle - 1, sibling->keys());
+      moveObjects(parent->children + middle + 1, parent->count - middle, sibling->children);
+      sibling->count = parent->count - middle - 1;
+      parent->count = middle;
+      child = sibling;
+    }
+    return right;
+  }
+
+  /* element is built in place from args, if that throws the leaf is shifted back */
+  template <typename... Args>
+  void emplaceInLeaf(Leaf* leaf, size_type index, Args&&... args)
+  {
+    shiftRight(leaf->values(), index, leaf->count);
+    try
+    {
+      ::new (static_cast<void*>(leaf->values() + index)) value_type(std::forward<Args>(args)...);
+    }
+    catch(...)
+    {
+      shiftLeft(leaf->values(), index, leaf->count + 1);
+      throw;
+    }
+    shiftRight(leaf->keys(), index, leaf->count);
+    try
+    {
+      ::new (static_cast<void*>(leaf->keys() + index)) key_type(leaf->values()[index].first);
+    }
+    catch(...)
+    {
+      shiftLeft(leaf->keys(), index, leaf->count + 1);
+      leaf->values()[index].~value_type();
+      shiftLeft(leaf->values(), index, leaf->count + 1);
+      throw;
+    }
+    ++leaf->count;
+    ++size;
+  }
+
+  template <typename KeyArgument, typename... Args>
+  std::pair<iterator, bool> tryEmplaceElement(KeyArgument&& key, Args&&... args)
+  {
+    if(root == nullptr)
+      root = firstLeaf = lastLeaf = new Leaf();
+    PathStep path[MAX_DEPTH];
+    size_type depth;
+    Leaf* leaf = descend(key, path, depth);
+    size_type index = countSmaller(leaf->keys(), leaf->count, key);
+    if(index < leaf->count && !(leaf->keys()[index] != key))
+      return std::make_pair(Iterator(this, leaf, index), false);
+    if(leaf->count == LEAF_CAPACITY)
+    {
+      Leaf* right = splitLeaf(leaf, path, depth, index == leaf->count && leaf->next == nullptr);
+      if(index > leaf->count)
+      {
+        index -= leaf->count;
+        leaf = right;
+      }
+    }
+    emplaceInLeaf(leaf, index, std::piecewise_construct, std::forward_as_tuple(std::forward<KeyArgument>(key)),
+                  std::forward_as_tuple(std::forward<Args>(args)...));
+    return std::make_pair(Iterator(this, leaf, index), true);
+  }
+
+  void mergeLeaves(Leaf* left, Leaf* right, Inner* parent, size_type separatorIndex)
+  {
+    moveObjects(right->keys(), right->count, left->keys() + left->count);
+    moveObjects(right->values(), right->count, left->values() + left->count);
+    left->count += right->count;
+    right->count = 0;
+    left->next = right->next;
+    if(right->next != nullptr)
+      right->next->previous = left;
+    else
+      lastLeaf = left;
+    delete right;
+    parent->keys()[separatorIndex].~key_type();
+    shiftLeft(parent->keys(), separatorIndex, parent->count);
+    shiftLeft(parent->children, separatorIndex + 1, parent->count + 1);
+    --parent->count;
+  }
+
+  /* separator between left and right comes down between their keys */
+  void mergeInners(Inner* left, Inner* right, Inner* parent, size_type separatorIndex)
+  {
+    ::new (static_cast<void*>(left->keys() + left->count)) key_type(std::move(parent->keys()[separatorIndex]));
+    parent->keys()[separatorIndex].~key_type();
+    shiftLeft(parent->keys(), separatorIndex, parent->count);
+    moveObjects(right->keys(), right->count, left->keys() + left->count + 1);
+    moveObjects(right->children, right->count + 1, left->children + left->count + 1);
+    left->count += right->count + 1;
+    right->count = 0;
+    delete right;
+    shiftLeft(parent->children, separatorIndex + 1, parent->count + 1);
+    --parent->count;
+  }
+
+  /* leaf that became less than half full takes an element from a sibling or is merged with it, merging can leave
+   * the parent less than half full, which is fixed the same way up to the root */
+  void rebalanceLeaf(Leaf* leaf, PathStep* path, size_type depth)
+  {
+    Inner* parent = path[depth - 1].node;
+    size_type index = path[depth - 1].childIndex;
+    Leaf* left = (index > 0) ? static_cast<Leaf*>(parent->children[index - 1]) : nullptr;
+    Leaf* right = (index < parent->count) ? static_cast<Leaf*>(parent->children[index + 1]) : nullptr;
+    if(left != nullptr && left->count > MIN_LEAF_COUNT)
+    {
+      key_type separator(left->keys()[left->count - 1]);
+      shiftRight(leaf->keys(), 0, leaf->count);
+      shiftRight(leaf->values(), 0, leaf->count);
+      moveObjects(left->keys() + left->count - 1, 1, leaf->keys());
+      moveObjects(left->values() + left->count - 1, 1, leaf->values());
+      --left->count;
+      ++leaf->count;
+      parent->keys()[index - 1] = std::move(separator);
+      return;
+    }
+    if(right != nullptr && right->count > MIN_LEAF_COUNT)
+    {
+      key_type separator(right->keys()[1]);
+      moveObjects(right->keys(), 1, leaf->keys() + leaf->count);
+      moveObjects(right->values(), 1, leaf->values() + leaf->count);
+      shiftLeft(right->keys(), 0, right->count);
+      shiftLeft(right->values(), 0, right->count);
+      --right->count;
+      ++leaf->count;
+      parent->keys()[index] = std::move(separator);
+      return;
+    }
+    if(left != nullptr)
+      mergeLeaves(left, leaf, parent, index - 1);
+    else
+      mergeLeaves(leaf, right, parent, index);
+
+    for(size_type level = depth - 1; ; --level)
+    {
+      Inner* node = path[level].node;
+      if(level == 0)
+      {
+        if(node->count == 0)
+        {
+          root = node->children[0];
+          delete node;
+        }
+        return;
+      }
+      if(node->count >= MIN_INNER_COUNT)
+        return;
+      parent = path[level - 1].node;
+      index = path[level - 1].childIndex;
+      Inner* leftInner = (index > 0) ? static_cast<Inner*>(parent->children[index - 1]) : nullptr;
+      Inner* rightInner = (index < parent->count) ? static_cast<Inner*>(parent->children[index + 1]) : nullptr;
+      if(leftInner != nullptr && leftInner->count > MIN_INNER_COUNT)
+      {
+        shiftRight(node->keys(), 0, node->count);
+        ::new (static_cast<void*>(node->keys())) key_type(std::move(parent->keys()[index - 1]));
+        parent->keys()[index - 1] = std::move(leftInner->keys()[leftInner->count - 1]);
+        leftInner->keys()[leftInner->count - 1].~key_type();
+        shiftRight(node->children, 0, node->count + 1);
+        node->children[0] = leftInner->children[leftInner->count];
+        --leftInner->count;
+        ++node->count;
+        return;
+      }
+      if(rightInner != nullptr && rightInner->count > MIN_INNER_COUNT)
+      {
+        ::new (static_cast<void*>(node->keys() + node->count)) key_type(std::move(parent->keys()[index]));
+        parent->keys()[index] = std::move(rightInner->keys()[0]);
+        rightInner->keys()[0].~key_type();
+        shiftLeft(rightInner->keys(), 0, rightInner->count);
+        node->children[node->count + 1] = rightInner->children[0];
+        shiftLeft(rightInner->children, 0, rightInner->count + 1);
+        --rightInner->count;
+        ++node->count;
+        return;
+      }
+      if(leftInner != nullptr)
+        mergeInners(leftInner, node, parent, index - 1);
+      else
+        mergeInners(node, rightInner, parent, index);
+    }
+  }
+
+  void eraseElement(const key_type& key)
+  {
+    PathStep path[MAX_DEPTH];
+    size_type depth;
+    Leaf* leaf = descend(key, path, depth);
+    size_type index = countSmaller(leaf->keys(), leaf->count, key);
+    leaf->keys()[index].~key_type();
+    shiftLeft(leaf->keys(), index, leaf->count);
+    leaf->values()[index].~value_type();
+    shiftLeft(leaf->values(), index, leaf->count);
+    --leaf->count;
+    --size;
+    if(depth == 0)
+    {
+      if(leaf->count == 0)
+        clearTree();
+    }
+    else if(leaf->count < MIN_LEAF_COUNT)
+      rebalanceLeaf(leaf, path, depth);
+  }
+
+  Node* cloneNode(const Node* from)
+  {
+    if(from->isLeaf)
+    {
+      const Leaf* fromLeaf = static_cast<const Leaf*>(from);
+      Leaf* leaf = new Leaf();
+      try
+      {
+        for(; leaf->count < fromLeaf->count; ++leaf->count)
+        {
+          ::new (static_cast<void*>(leaf->values() + leaf->count)) value_type(fromLeaf->values()[leaf->count]);
+          try
+          {
+            ::new (static_cast<void*>(leaf->keys() + leaf->count)) key_type(fromLeaf->keys()[leaf->count]);
+          }
+          catch(...)
+          {
+            leaf->values()[leaf->count].~value_type();
+            throw;
+          }
+        }
+      }
+      catch(...)
+      {
+        delete leaf;
+        throw;
+      }
+      leaf->previous = lastLeaf;
+      if(lastLeaf != nullptr)
+        lastLeaf->next = leaf;
+      else
+        firstLeaf = leaf;
+      lastLeaf = leaf;
+      return leaf;
+    }
+    const Inner* fromInner = static_cast<const Inner*>(from);
+    Inner* inner = new Inner();
+    size_type children = 0;
+    try
+    {
+      for(; children <= fromInner->count; ++children)
+        inner->children[children] = cloneNode(fromInner->children[children]);
+      for(; inner->count < fromInner->count; ++inner->count)
+        ::new (static_cast<void*>(inner->keys() + inner->count)) key_type(fromInner->keys()[inner->count]);
+    }
+    catch(...)
+    {
+      for(size_type i = 0; i < children; ++i)
+        destroySubtree(inner->children[i]);
+      delete inner;
+      throw;
+    }
+    return inner;
+  }
+
+  void swapContents(BTreeMap& other)
+  {
+    std::swap(root, other.root);
+    std::swap(firstLeaf, other.firstLeaf);
+    std::swap(lastLeaf, other.lastLeaf);
+    std::swap(size, other.size);
+  }
+
+public:
+  /* elements with keys from [first, last) of a map, nothing is copied: it is a pair of iterators found in O(log n),
+   * walking it costs O(k) for k elements; like any iterator it is invalidated by inserting or removing elements */
+  template <typename RangeIterator>
+  class RangeView
+  {
+    RangeIterator first;
+    RangeIterator last;
+
+  public:
+    RangeView(const RangeIterator& from, const RangeIterator& to) : first(from), last(to)
+    {}
+
+    RangeIterator begin() const
+    {
+      return first;
+    }
+
+    RangeIterator end() const
+    {
+      return last;
+    }
+
+    bool isEmpty() const
+    {
+      return first == last;
+    }
+  };
+
+  using range_view = RangeView<iterator>;
+  using const_range_view = RangeView<const_iterator>;
+
+  BTreeMap()
+  {
+    root = nullptr;
+    firstLeaf = lastLeaf = nullptr;
+    size = 0;
+  }
+
+  /* a repeated key gets the last of its values */
+  template <typename InputIterator>
+  BTreeMap(InputIterator first, InputIterator last) : BTreeMap()
+  {
+    for(; first != last; ++first)
+      this->operator[](first->first) = first->second;
+  }
+
+  BTreeMap(std::initializer_list<value_type> list) : BTreeMap(list.begin(), list.end())
+  {}
+
+  /* the copy has the same shape as other, built in one linear pass */
+  BTreeMap(const BTreeMap& other) : BTreeMap()
+  {
+    if(other.root == nullptr)
+      return;
+    root = cloneNode(other.root);
+    size = other.size;
+  }
+
+  BTreeMap(BTreeMap&& other) : BTreeMap()
+  {
+    swapContents(other);
+  }
+
+  ~BTreeMap()
+  {
+    clearTree();
+  }
+
+  BTreeMap& operator=(const BTreeMap& other)
+  {
+    if(this == &other)
+      return *this;
+    BTreeMap copy(other);
+    swapContents(copy);
+    return *this;
+  }
+
+  BTreeMap& operator=(BTreeMap&& other)
+  {
+    if(this == &other)
+      return *this;
+    clearTree();
+    swapContents(other);
+    return *this;
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    return tryEmplaceElement(key).first->second;
+  }
+
+  mapped_type& operator[](key_type&& key)
+  {
+    return tryEmplaceElement(std::move(key)).first->second;
+  }
+
+  /* inserts (key, mapped_type(args...)) if key is missing, otherwise leaves args untouched; second is true if it inserted */
+  template <typename... Args>
+  std::pair<iterator, bool> tryEmplace(const key_type& key, Args&&... args)
+  {
+    return tryEmplaceElement(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> tryEmplace(key_type&& key, Args&&... args)
+  {
+    return tryEmplaceElement(std::move(key), std::forward<Args>(args)...);
+  }
+
+  /* inserts (key, value) or assigns value to the element already there; second is true if it inserted */
+  template <typename MappedArgument>
+  std::pair<iterator, bool> insertOrAssign(const key_type& key, MappedArgument&& value)
+  {
+    auto result = tryEmplace(key, std::forward<MappedArgument>(value));
+    if(!result.second)
+      result.first->second = std::forward<MappedArgument>(value);
+    return result;
+  }
+
+  template <typename MappedArgument>
+  std::pair<iterator, bool> insertOrAssign(key_type&& key, MappedArgument&& value)
+  {
+    auto result = tryEmplace(std::move(key), std::forward<MappedArgument>(value));
+    if(!result.second)
+      result.first->second = std::forward<MappedArgument>(value);
+    return result;
+  }
+
+  /* element is built from args first, its key is needed to find a place */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    value_type element(std::forward<Args>(args)...);
+    return tryEmplaceElement(element.first, std::move(element.second));
+  }
+
+  /* find() and valueOf() also take key types marked by IsTransparentLookup, as in TreeMap */
+  template <typename LookupKey>
+  using comparable_key = transparent_lookup_key<key_type, LookupKey>;
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    auto iteratorToElement = find(key);
+    if(iteratorToElement == cend())
+      throw std::out_of_range("in function valueOf(const key_type&), invalid key");
+    return (*iteratorToElement).second;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    auto iteratorToElement = find(key);
+    if(iteratorToElement == end())
+      throw std::out_of_range("in function valueOf(const key_type&), invalid key");
+    return (*iteratorToElement).second;
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  const mapped_type& valueOf(const LookupKey& key) const
+  {
+    auto iteratorToElement = find(key);
+    if(iteratorToElement == cend())
+      throw std::out_of_range("in function valueOf(const LookupKey&), invalid key");
+    return (*iteratorToElement).second;
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  mapped_type& valueOf(const LookupKey& key)
+  {
+    auto iteratorToElement = find(key);
+    if(iteratorToElement == end())
+      throw std::out_of_range("in function valueOf(const LookupKey&), invalid key");
+    return (*iteratorToElement).second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    auto element = findElement(key);
+    return ConstIterator(this, element.first, element.second);
+  }
+
+  iterator find(const key_type& key)
+  {
+    auto element = findElement(key);
+    return Iterator(this, element.first, element.second);
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  const_iterator find(const LookupKey& key) const
+  {
+    auto element = findElement(key);
+    return ConstIterator(this, element.first, element.second);
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  iterator find(const LookupKey& key)
+  {
+    auto element = findElement(key);
+    return Iterator(this, element.first, element.second);
+  }
+
+  /* lowerBound(), upperBound(), equalRange() and range() take the same key types as find(), each one descends the tree once */
+  const_iterator lowerBound(const key_type& key) const
+  {
+    auto element = lowerBoundElement(key);
+    return ConstIterator(this, element.first, element.second);
+  }
+
+  iterator lowerBound(const key_type& key)
+  {
+    auto element = lowerBoundElement(key);
+    return Iterator(this, element.first, element.second);
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  const_iterator lowerBound(const LookupKey& key) const
+  {
+    auto element = lowerBoundElement(key);
+    return ConstIterator(this, element.first, element.second);
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  iterator lowerBound(const LookupKey& key)
+  {
+    auto element = lowerBoundElement(key);
+    return Iterator(this, element.first, element.second);
+  }
+
+  const_iterator upperBound(const key_type& key) const
+  {
+    auto element = upperBoundElement(key);
+    return ConstIterator(this, element.first, element.second);
+  }
+
+  iterator upperBound(const key_type& key)
+  {
+    auto element = upperBoundElement(key);
+    return Iterator(this, element.first, element.second);
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  const_iterator upperBound(const LookupKey& key) const
+  {
+    auto element = upperBoundElement(key);
+    return ConstIterator(this, element.first, element.second);
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  iterator upperBound(const LookupKey& key)
+  {
+    auto element = upperBoundElement(key);
+    return Iterator(this, element.first, element.second);
+  }
+
+  /* (lowerBound(key), upperBound(key)), holds at most one element */
+  std::pair<const_iterator, const_iterator> equalRange(const key_type& key) const
+  {
+    auto elements = equalRangeElements(key);
+    return std::make_pair(ConstIterator(this, elements.first.first, elements.first.second),
+                          ConstIterator(this, elements.second.first, elements.second.second));
+  }
+
+  std::pair<iterator, iterator> equalRange(const key_type& key)
+  {
+    auto elements = equalRangeElements(key);
+    return std::make_pair(Iterator(this, elements.first.first, elements.first.second),
+                          Iterator(this, elements.second.first, elements.second.second));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  std::pair<const_iterator, const_iterator> equalRange(const LookupKey& key) const
+  {
+    auto elements = equalRangeElements(key);
+    return std::make_pair(ConstIterator(this, elements.first.first, elements.first.second),
+                          ConstIterator(this, elements.second.first, elements.second.second));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  std::pair<iterator, iterator> equalRange(const LookupKey& key)
+  {
+    auto elements = equalRangeElements(key);
+    return std::make_pair(Iterator(this, elements.first.first, elements.first.second),
+                          Iterator(this, elements.second.first, elements.second.second));
+  }
+
+  /* elements with first <= key < last in order, empty if last <= first, e.g. for(auto& element : map.range(a, b)) */
+  const_range_view range(const key_type& first, const key_type& last) const
+  {
+    auto elements = rangeElements(first, last);
+    return const_range_view(ConstIterator(this, elements.first.first, elements.first.second),
+                            ConstIterator(this, elements.second.first, elements.second.second));
+  }
+
+  range_view range(const key_type& first, const key_type& last)
+  {
+    auto elements = rangeElements(first, last);
+    return range_view(Iterator(this, elements.first.first, elements.first.second),
+                      Iterator(this, elements.second.first, elements.second.second));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  const_range_view range(const LookupKey& first, const LookupKey& last) const
+  {
+    auto elements = rangeElements(first, last);
+    return const_range_view(ConstIterator(this, elements.first.first, elements.first.second),
+                            ConstIterator(this, elements.second.first, elements.second.second));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  range_view range(const LookupKey& first, const LookupKey& last)
+  {
+    auto elements = rangeElements(first, last);
+    return range_view(Iterator(this, elements.first.first, elements.first.second),
+                      Iterator(this, elements.second.first, elements.second.second));
+  }
+
+  void remove(const key_type& key)
+  {
+    remove(find(key));
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it == end())
+      throw std::out_of_range("in function: remove(const const_iterator&), cannot remove end() or if empty or non-existing element");
+    eraseElement(it.leaf->keys()[it.index]);
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  bool operator==(const BTreeMap& other) const
+  {
+    if(size != other.size)
+      return false;
+    auto thisTree = cbegin();
+    auto otherTree = other.cbegin();
+    while(thisTree != cend() && otherTree != other.cend())
+    {
+      if((*thisTree).first != (*otherTree).first || (*thisTree).second != (*otherTree).second)
+        return false;
+      ++thisTree;
+      ++otherTree;
+    }
+    return true;
+  }
+
+  bool operator!=(const BTreeMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return Iterator(this, firstLeaf, 0);
+  }
+
+  iterator end()
+  {
+    return Iterator(this, nullptr, 0);
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(this, firstLeaf, 0);
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(this, nullptr, 0);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+};
+
+template <typename KeyType, typename ValueType>
+constexpr typename BTreeMap<KeyType, ValueType>::size_type BTreeMap<KeyType, ValueType>::NODE_BYTES;
+
+template <typename KeyType, typename ValueType>
+constexpr typename BTreeMap<KeyType, ValueType>::size_type BTreeMap<KeyType, ValueType>::LEAF_CAPACITY;
+
+template <typename KeyType, typename ValueType>
+constexpr typename BTreeMap<KeyType, ValueType>::size_type BTreeMap<KeyType, ValueType>::INNER_CAPACITY;
+
+template <typename KeyType, typename ValueType>
+constexpr typename BTreeMap<KeyType, ValueType>::size_type BTreeMap<KeyType, ValueType>::MIN_LEAF_COUNT;
+
+template <typename KeyType, typename ValueType>
+constexpr typename BTreeMap<KeyType, ValueType>::size_type BTreeMap<KeyType, ValueType>::MIN_INNER_COUNT;
+
+template <typename KeyType, typename ValueType>
+constexpr typename BTreeMap<KeyType, ValueType>::size_type BTreeMap<KeyType, ValueType>::MAX_DEPTH;
+
+template <typename KeyType, typename ValueType>
+class BTreeMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename BTreeMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename BTreeMap::value_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const typename BTreeMap::value_type*;
+private:
+  const BTreeMap* tree_ptr;
+  typename BTreeMap::Leaf* leaf;                        // nullptr for end()
+  typename BTreeMap::size_type index;
+  friend class BTreeMap;
+
+  void moveForward()
+  {
+    if(++index == leaf->count)
+    {
+      leaf = leaf->next;
+      index = 0;
+    }
+  }
+
+  void moveBackward()
+  {
+    if(leaf == nullptr)
+    {
+      leaf = tree_ptr->lastLeaf;
+      index = leaf->count - 1;
+    }
+    else if(index == 0)
+    {
+      leaf = leaf->previous;
+      index = leaf->count - 1;
+    }
+    else
+      --index;
+  }
+
+  bool pointsAtBeginning() const
+  {
+    return leaf == tree_ptr->firstLeaf && index == 0;
+  }
+
+public:
+  explicit ConstIterator(const BTreeMap* tree = nullptr, typename BTreeMap::Leaf* leafOfElement = nullptr, typename BTreeMap::size_type indexInLeaf = 0)
+    : tree_ptr(tree), leaf(leafOfElement), index(indexInLeaf)
+  {}
+
+  ConstIterator(const ConstIterator& other)
+  {
+    tree_ptr = other.tree_ptr;
+    leaf = other.leaf;
+    index = other.index;
+  }
+
+  ConstIterator& operator++()
+  {
+    if(leaf == nullptr)
+      throw std::out_of_range("in function: operator++(), cannot increment end()");
+    moveForward();
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    if(leaf == nullptr)
+      throw std::out_of_range("in function: operator++(int), cannot increment end()");
+    auto temp(*this);
+    moveForward();
+    return temp;
+  }
+
+  ConstIterator& operator--()
+  {
+    if(tree_ptr->isEmpty() || pointsAtBeginning())
+      throw std::out_of_range("in function: operator--(), cannot decrement begin() or empty tree");
+    moveBackward();
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    if(tree_ptr->isEmpty() || pointsAtBeginning())
+      throw std::out_of_range("in function: operator--(int), cannot decrement begin() or empty tree");
+    auto temp(*this);
+    moveBackward();
+    return temp;
+  }
+
+  reference operator*() const
+  {
+    if(leaf == nullptr)
+      throw std::out_of_range("in function: operator*(), dereferencing end()");
+    return leaf->values()[index];
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return leaf == other.leaf && index == other.index;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class BTreeMap<KeyType, ValueType>::Iterator : public BTreeMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename BTreeMap::reference;
+  using pointer = typename BTreeMap::value_type*;
+
+  explicit Iterator(const BTreeMap* tree = nullptr, typename BTreeMap::Leaf* leafOfElement = nullptr, typename BTreeMap::size_type indexInLeaf = 0)
+    : ConstIterator(tree, leafOfElement, indexInLeaf)
+  {}
+
+  Iterator(const ConstIterator& other) : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    // ugly cast, yet reduces code duplication.
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_BTREEMAP_H */
@@ -0,0 +1,216 @@
+#ifndef AISDI_MAPS_CONCURRENT_HASHMAP_H
+#define AISDI_MAPS_CONCURRENT_HASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <functional>
+#include <memory>
+#include <mutex>
+#if __cplusplus >= 201402L
+#include <shared_mutex>
+#endif
+
+#include "HashMap.h"
+
+namespace aisdi
+{
+
+/* HashMap split into independent shards, each one guarded by its own reader-writer lock, so threads working on different
+ * shards never wait for each other and readers of one shard don't wait for other readers. Key goes to the shard given by
+ * the top bits of its hash mixed with constants no hash policy uses, inside the shard the hash policy picks the slot;
+ * were shard bits the bits the policy takes position or tag from, all keys of a shard would crowd into a part of its table.
+ * No reference or iterator into a shard is handed out, because it would outlive the lock: values are copied out,
+ * modified in place by a function called under the lock, or copied together into a snapshot. */
+template <typename KeyType, typename ValueType, typename Hasher = std::hash<KeyType>, typename KeyEqual = std::equal_to<KeyType>,
+          typename HashPolicy = MixingHashPolicy>
+class ConcurrentHashMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using size_type = std::size_t;
+  using shard_map = HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>;
+
+private:
+#if __cplusplus >= 201402L
+  using shard_mutex = std::shared_timed_mutex;
+  using read_lock = std::shared_lock<shard_mutex>;
+#else
+  using shard_mutex = std::mutex;                       // no shared locks before C++14, readers take the lock exclusively
+  using read_lock = std::unique_lock<shard_mutex>;
+#endif
+  using write_lock = std::unique_lock<shard_mutex>;
+
+  static constexpr size_type CACHE_LINE_SIZE = 64;
+  static constexpr size_type DEFAULT_NUM_OF_SHARDS = 64;
+
+  struct Shard
+  {
+    mutable shard_mutex lock;
+    shard_map map;
+    char padding[CACHE_LINE_SIZE];                      // keeps locks of neighbouring shards off one cache line
+  };
+
+  std::unique_ptr<Shard[]> shards;
+  size_type numOfShards;
+  size_type shardShift;                                 // 64 - log2(numOfShards)
+  Hasher hasher;
+  KeyEqual keysEqual;
+
+  template <typename LookupKey>
+  Shard& shardOf(const LookupKey& key) const
+  {
+    return shards[shardIndexOf(key)];
+  }
+
+public:
+  /* number of shards is rounded up to a power of two, a few times the number of threads keeps collisions rare */
+  explicit ConcurrentHashMap(size_type shardsAmount = DEFAULT_NUM_OF_SHARDS, const Hasher& keyHasher = Hasher(), const KeyEqual& keyEqual = KeyEqual())
+    : hasher(keyHasher), keysEqual(keyEqual)
+  {
+    numOfShards = 1;
+    shardShift = 64;
+    while(numOfShards < shardsAmount)
+    {
+      numOfShards *= 2;
+      --shardShift;
+    }
+    shards.reset(new Shard[numOfShards]);
+    for(size_type i = 0; i < numOfShards; ++i)
+      shards[i].map = shard_map(keyHasher, keyEqual);
+  }
+
+  ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+  ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+  /* shard the key goes to: wyhash-style fold of the hash with its own seed and multiplier, so it doesn't depend
+   * on the bits any hash policy uses inside the shard */
+  template <typename LookupKey>
+  size_type shardIndexOf(const LookupKey& key) const
+  {
+    if(numOfShards == 1)
+      return 0;
+    std::uint64_t low, high;
+    multiplyWide(static_cast<std::uint64_t>(hasher(key)) ^ 0x8EBC6AF09C88C6E3ULL, 0x589965CC75374CC3ULL, low, high);
+    return static_cast<size_type>((low ^ high) >> shardShift);
+  }
+
+  size_type getNumOfShards() const
+  {
+    return numOfShards;
+  }
+
+  /* copies value of key to result and returns true, or returns false if there is no such key */
+  template <typename LookupKey>
+  bool find(const LookupKey& key, mapped_type& result) const
+  {
+    Shard& shard = shardOf(key);
+    read_lock guard(shard.lock);
+    auto element = shard.map.find(key);
+    if(element == shard.map.end())
+      return false;
+    result = element->second;
+    return true;
+  }
+
+  template <typename LookupKey>
+  mapped_type valueOf(const LookupKey& key) const
+  {
+    Shard& shard = shardOf(key);
+    read_lock guard(shard.lock);
+    auto element = shard.map.find(key);
+    if(element == shard.map.end())
+      throw std::out_of_range("in function valueOf(const LookupKey&), cannot find value of invalid key");
+    return element->second;
+  }
+
+  /* if key is missing inserts (key, value), otherwise calls update(value of key); both happen under one lock,
+   * so concurrent upserts of one key are never lost; returns true if it inserted */
+  template <typename Updater>
+  bool upsert(const key_type& key, const mapped_type& value, Updater update)
+  {
+    Shard& shard = shardOf(key);
+    write_lock guard(shard.lock);
+    auto result = shard.map.tryEmplace(key, value);
+    if(!result.second)
+      update(result.first->second);
+    return result.second;
+  }
+
+  template <typename... Args>
+  bool tryEmplace(const key_type& key, Args&&... args)
+  {
+    Shard& shard = shardOf(key);
+    write_lock guard(shard.lock);
+    return shard.map.tryEmplace(key, std::forward<Args>(args)...).second;
+  }
+
+  template <typename MappedArgument>
+  bool insertOrAssign(const key_type& key, MappedArgument&& value)
+  {
+    Shard& shard = shardOf(key);
+    write_lock guard(shard.lock);
+    return shard.map.insertOrAssign(key, std::forward<MappedArgument>(value)).second;
+  }
+
+  void remove(const key_type& key)
+  {
+    Shard& shard = shardOf(key);
+    write_lock guard(shard.lock);
+    shard.map.remove(key);
+  }
+
+  /* sum of shard sizes, each read under its own lock, so it may mix moments when other threads keep modifying the map */
+  size_type getSize() const
+  {
+    size_type size = 0;
+    for(size_type i = 0; i < numOfShards; ++i)
+    {
+      read_lock guard(shards[i].lock);
+      size += shards[i].map.getSize();
+    }
+    return size;
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  /* calls visit(key, value) for every element, one shard at a time under its read lock, visit must not use this map */
+  template <typename Visitor>
+  void forEach(Visitor visit) const
+  {
+    for(size_type i = 0; i < numOfShards; ++i)
+    {
+      read_lock guard(shards[i].lock);
+      for(const auto& element : shards[i].map)
+        visit(element.first, element.second);
+    }
+  }
+
+  /* copy of the whole map at one moment: read locks of all shards are taken in index order (so two snapshots can't
+   * deadlock) and held until everything is copied, the copy can then be iterated freely */
+  shard_map snapshot() const
+  {
+    std::unique_ptr<read_lock[]> guards(new read_lock[numOfShards]);
+    size_type size = 0;
+    for(size_type i = 0; i < numOfShards; ++i)
+    {
+      guards[i] = read_lock(shards[i].lock);
+      size += shards[i].map.getSize();
+    }
+    shard_map copy(hasher, keysEqual);
+    copy.reserve(size);
+    for(size_type i = 0; i < numOfShards; ++i)
+      for(const auto& element : shards[i].map)
+        copy.tryEmplace(element.first, element.second);
+    return copy;
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_CONCURRENT_HASHMAP_H */
@@ -2,17 +2,142 @@
 #define AISDI_MAPS_HASHMAP_H
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <initializer_list>
 #include <stdexcept>
 #include <utility>
 #include <functional>
+#include <memory>
+#include <new>
 #include <vector>
-#include <list>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <tuple>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
+/* hash policies turn what the hasher returned into position of the first probed slot and a 7 bit tag kept in the control byte,
+ * tables have power of two sizes, so position is taken with a mask or a shift, never with a division */
+
+/* opt-in: position is the low bits of the hash as it is, so sequential integer keys (std::hash is identity) land in sequential slots,
+ * tag is taken from the top bits of a multiplied hash, so keys sharing a position still have different tags;
+ * keys differing only in high bits (multiples of a power of two) all share a few positions, so it is not the default */
+struct MaskHashPolicy
+{
+  static std::size_t mix(std::size_t hash)
+  {
+    return hash;
+  }
+
+  static std::size_t positionOf(std::size_t hash, std::size_t capacity)
+  {
+    return hash & (capacity - 1);
+  }
+
+  static signed char tagOf(std::size_t hash)
+  {
+    return static_cast<signed char>((static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> 57);
+  }
+};
+
+/* full 128 bit product of two 64 bit numbers as its low and high halves, one instruction where the compiler has
+ * a 128 bit type, otherwise put together from four products of 32 bit halves */
+inline void multiplyWide(std::uint64_t first, std::uint64_t second, std::uint64_t& low, std::uint64_t& high)
+{
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 uint128;
+  uint128 product = static_cast<uint128>(first) * second;
+  low = static_cast<std::uint64_t>(product);
+  high = static_cast<std::uint64_t>(product >> 64);
+#else
+  std::uint64_t firstLow = first & 0xFFFFFFFFULL, firstHigh = first >> 32;
+  std::uint64_t secondLow = second & 0xFFFFFFFFULL, secondHigh = second >> 32;
+  std::uint64_t lowLow = firstLow * secondLow;
+  std::uint64_t lowHigh = firstLow * secondHigh;
+  std::uint64_t highLow = firstHigh * secondLow;
+  std::uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFFULL) + highLow;   // at most 3 * (2^32 - 1) + ..., no overflow
+  low = (middle << 32) | (lowLow & 0xFFFFFFFFULL);
+  high = firstHigh * secondHigh + (lowHigh >> 32) + (middle >> 32);
+#endif
+}
+
+/* default: hash is mixed first, like in wyhash: 128 bit product of hash and a constant with both halves xored together,
+ * so every bit of the hash reaches the position, also for hashers whose low bits are poor (std::hash of integers, pointers) */
+struct MixingHashPolicy
+{
+  static std::size_t mix(std::size_t hash)
+  {
+    std::uint64_t low, high;
+    multiplyWide(static_cast<std::uint64_t>(hash) ^ 0xA0761D6478BD642FULL, 0xE7037ED1A0B428DBULL, low, high);
+    return static_cast<std::size_t>(low ^ high);
+  }
+
+  static std::size_t positionOf(std::size_t hash, std::size_t capacity)
+  {
+    return hash & (capacity - 1);
+  }
+
+  static signed char tagOf(std::size_t hash)
+  {
+    return static_cast<signed char>(static_cast<std::uint64_t>(hash) >> 57);
+  }
+};
+
+/* Fibonacci hashing: hash is multiplied by 2^64 / golden ratio, position comes from the top bits of the product, tag from the lowest */
+struct FibonacciHashPolicy
+{
+  static std::size_t mix(std::size_t hash)
+  {
+    return static_cast<std::size_t>(static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL);
+  }
+
+  static std::size_t positionOf(std::size_t hash, std::size_t capacity)
+  {
+    return static_cast<std::size_t>(static_cast<std::uint64_t>(hash) >> (64 - __builtin_ctzll(capacity)));
+  }
+
+  static signed char tagOf(std::size_t hash)
+  {
+    return static_cast<signed char>(hash & 0x7F);
+  }
+};
+
+/* hasher or key equality with is_transparent member type accepts other types than the key itself */
+template <typename Functor, typename = void>
+struct IsTransparent : std::false_type
+{};
+
+template <typename Functor>
+struct IsTransparent<Functor, typename std::conditional<true, void, typename Functor::is_transparent>::type> : std::true_type
+{};
+
+#if __cplusplus >= 201703L
+/* transparent hasher for std::string keys, gives the same hash for std::string, std::string_view and const char* */
+struct StringHash
+{
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view key) const
+  {
+    return std::hash<std::string_view>()(key);
+  }
+};
+#endif
+
+/* flat open addressing table: elements are kept inline in one array of slots, next to it there is an array of control bytes,
+ * one per slot, telling if the slot is empty, deleted or full; a full slot keeps 7 bits of key's hash (tag),
+ * so lookup compares whole keys only in slots whose tag matches. Control bytes are checked GROUP_WIDTH at a time. */
+template <typename KeyType, typename ValueType, typename Hasher = std::hash<KeyType>, typename KeyEqual = std::equal_to<KeyType>,
+          typename HashPolicy = MixingHashPolicy>
 class HashMap
 {
 public:
@@ -22,93 +147,657 @@ public:
   using size_type = std::size_t;
   using reference = value_type&;
   using const_reference = const value_type&;
-  using bucket_list = std::list<value_type>;
 
   class ConstIterator;
   class Iterator;
   using iterator = Iterator;
   using const_iterator = ConstIterator;
 
+  /* STOP_THE_WORLD moves all elements to a bigger table inside one insert, INCREMENTAL spreads it over following operations,
+   * so no single operation takes longer than moving a few slots */
+  enum RehashMode {STOP_THE_WORLD, INCREMENTAL};
+
 private:
-  std::vector<bucket_list> tableOfBuckets;
-  size_type numberOfBuckets;
+  using control_type = signed char;
+  using group_mask = std::uint32_t;                     // bit i set if i-th control byte of a group matches
+
+  static constexpr control_type EMPTY = -128;           // 0b10000000
+  static constexpr control_type DELETED = -2;           // 0b11111110, slot was full, probing has to go on past it
+  static constexpr size_type GROUP_WIDTH = 16;
+  static constexpr size_type INITIAL_CAPACITY = 32;     // capacity is always a power of two and at least GROUP_WIDTH
+
+#if defined(__SSE2__) && !defined(AISDI_HASHMAP_SCALAR_PROBING)
+  /* GROUP_WIDTH consecutive control bytes compared at once by one SSE2 instruction */
+  class Group
+  {
+    __m128i controlBytes;
+
+  public:
+    explicit Group(const control_type* position) : controlBytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(position)))
+    {}
+
+    group_mask match(control_type tag) const
+    {
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(controlBytes, _mm_set1_epi8(tag)));
+    }
+
+    group_mask matchEmpty() const
+    {
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(controlBytes, _mm_set1_epi8(EMPTY)));
+    }
+
+    group_mask matchEmptyOrDeleted() const                // EMPTY and DELETED are the only values below -1
+    {
+      return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), controlBytes));
+    }
+
+    group_mask matchFull() const                          // full slots are the only ones with high bit cleared
+    {
+      return ~_mm_movemask_epi8(controlBytes) & 0xFFFF;
+    }
+  };
+#else
+  /* scalar fallback: GROUP_WIDTH consecutive control bytes compared 8 at a time inside 64 bit words,
+   * masks mean the same as in SSE2 version, so both versions probe the same slots */
+  class Group
+  {
+    static constexpr std::uint64_t LOW_BITS = 0x0101010101010101ULL;
+    static constexpr std::uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+    std::uint64_t words[2];
+
+    static group_mask compress(std::uint64_t highBits)  // high bit of byte i -> bit i
+    {
+      return static_cast<group_mask>(((highBits >> 7) * 0x0102040810204080ULL) >> 56);
+    }
+
+    template <typename Matcher>
+    group_mask matchWith(Matcher matcher) const
+    {
+      return compress(matcher(words[0])) | (compress(matcher(words[1])) << 8);
+    }
+
+  public:
+    explicit Group(const control_type* position)
+    {
+      std::memcpy(words, position, sizeof(words));
+    }
+
+    /* may report a byte right after a matching one too, it only costs one more tag comparison */
+    group_mask match(control_type tag) const
+    {
+      std::uint64_t pattern = LOW_BITS * static_cast<unsigned char>(tag);
+      return matchWith([pattern](std::uint64_t word)
+      {
+        std::uint64_t difference = word ^ pattern;
+        return (difference - LOW_BITS) & ~difference & HIGH_BITS;
+      });
+    }
+
+    group_mask matchEmpty() const                         // only EMPTY has high bit set and bit 1 cleared
+    {
+      return matchWith([](std::uint64_t word) { return word & ~(word << 6) & HIGH_BITS; });
+    }
+
+    group_mask matchEmptyOrDeleted() const                // only EMPTY and DELETED have high bit set and bit 0 cleared
+    {
+      return matchWith([](std::uint64_t word) { return word & ~(word << 7) & HIGH_BITS; });
+    }
+
+    group_mask matchFull() const
+    {
+      return matchWith([](std::uint64_t word) { return ~word & HIGH_BITS; });
+    }
+  };
+#endif
+
+  static size_type countTrailingZeros(group_mask mask)
+  {
+    return __builtin_ctz(mask);
+  }
+
+  static size_type maxLoad(size_type tableCapacity)     // table is rebuilt when it is 7/8 full
+  {
+    return tableCapacity - tableCapacity / 8;
+  }
+
+  static bool isFull(control_type control)
+  {
+    return control >= 0;
+  }
+
+  static control_type tagOf(size_type hash)
+  {
+    return HashPolicy::tagOf(hash);
+  }
+
+  /* one open addressing table, controls has capacity + GROUP_WIDTH bytes, the last GROUP_WIDTH are copies of the first ones,
+   * so a group starting anywhere in the table can be read without wrapping around; capacity 0 means no table
+   * bit g of occupiedGroups is set when slots GROUP_WIDTH * g .. GROUP_WIDTH * (g + 1) - 1 hold an element, so scans skip
+   * 64 groups of a sparse table per word */
+  struct Table
+  {
+    std::vector<control_type> controls;
+    std::vector<std::uint64_t> occupiedGroups;
+    value_type* slots = nullptr;
+    size_type capacity = 0;
+
+    size_type positionOf(size_type hash) const
+    {
+      return HashPolicy::positionOf(hash, capacity);
+    }
+
+    void writeControl(size_type index, control_type control)
+    {
+      controls[index] = control;
+      if(index < GROUP_WIDTH)
+        controls[capacity + index] = control;
+    }
+
+    void setControl(size_type index, control_type tag)
+    {
+      size_type group = index / GROUP_WIDTH;
+      occupiedGroups[group / 64] |= std::uint64_t(1) << (group % 64);
+      writeControl(index, tag);
+    }
+
+    /* marks a full slot EMPTY or DELETED, returns full slots left in its group (bit i for slot GROUP_WIDTH * group + i),
+     * the group is read before the control byte is written, so the read doesn't wait for the write */
+    group_mask releaseSlot(size_type index, control_type control)
+    {
+      size_type group = index / GROUP_WIDTH;
+      group_mask fullLeft = Group(controls.data() + group * GROUP_WIDTH).matchFull() & ~(group_mask(1) << (index % GROUP_WIDTH));
+      if(fullLeft == 0)
+        occupiedGroups[group / 64] &= ~(std::uint64_t(1) << (group % 64));
+      writeControl(index, control);
+      return fullLeft;
+    }
+
+    /* groups are visited at offsets GROUP_WIDTH * (1 + 2 + ... + i), which reaches every group of a power of two table
+     * returns capacity if key isn't there */
+    template <typename LookupKey>
+    size_type find(const LookupKey& key, size_type hash, const KeyEqual& keysEqual) const
+    {
+      if(capacity == 0)
+        return 0;
+      control_type tag = tagOf(hash);
+      size_type position = positionOf(hash);
+      for(size_type step = GROUP_WIDTH; ; step += GROUP_WIDTH)
+      {
+        Group group(controls.data() + position);
+        for(group_mask mask = group.match(tag); mask != 0; mask &= mask - 1)
+        {
+          size_type index = (position + countTrailingZeros(mask)) & (capacity - 1);
+          if(controls[index] == tag && keysEqual(slots[index].first, key))
+            return index;
+        }
+        if(group.matchEmpty() != 0)
+          return capacity;
+        position = (position + step) & (capacity - 1);
+      }
+    }
+
+    size_type findFreeSlot(size_type hash) const
+    {
+      size_type position = positionOf(hash);
+      for(size_type step = GROUP_WIDTH; ; step += GROUP_WIDTH)
+      {
+        group_mask mask = Group(controls.data() + position).matchEmptyOrDeleted();
+        if(mask != 0)
+          return (position + countTrailingZeros(mask)) & (capacity - 1);
+        position = (position + step) & (capacity - 1);
+      }
+    }
+
+    /* first full slot in [from, to), to if there is none: rest of the group of from is checked, then the next
+     * occupied group is taken from occupiedGroups, so the cost doesn't depend on how many empty groups lie between */
+    size_type nextFullSlot(size_type from, size_type to) const
+    {
+      if(from >= to)
+        return to;
+      size_type group = from / GROUP_WIDTH;
+      group_mask full = Group(controls.data() + group * GROUP_WIDTH).matchFull() >> (from % GROUP_WIDTH);
+      if(full != 0)
+        return std::min(from + countTrailingZeros(full), to);
+      for(++group; group * GROUP_WIDTH < to; )
+      {
+        std::uint64_t groups = occupiedGroups[group / 64] >> (group % 64);
+        if(groups == 0)
+        {
+          group = (group / 64 + 1) * 64;
+          continue;
+        }
+        group += __builtin_ctzll(groups);
+        return std::min(group * GROUP_WIDTH + countTrailingZeros(Group(controls.data() + group * GROUP_WIDTH).matchFull()), to);
+      }
+      return to;
+    }
+
+    /* last full slot before from, capacity if there is none */
+    size_type previousFullSlot(size_type from) const
+    {
+      if(from == 0)
+        return capacity;
+      size_type group = (from - 1) / GROUP_WIDTH;
+      group_mask full = Group(controls.data() + group * GROUP_WIDTH).matchFull() & ((group_mask(2) << ((from - 1) % GROUP_WIDTH)) - 1);
+      while(full == 0)
+      {
+        if(group == 0)
+          return capacity;
+        --group;
+        std::uint64_t groups = occupiedGroups[group / 64] & (~std::uint64_t(0) >> (63 - group % 64));
+        while(groups == 0)
+        {
+          if(group < 64)
+            return capacity;
+          group = (group / 64) * 64 - 1;
+          groups = occupiedGroups[group / 64];
+        }
+        group = (group / 64) * 64 + 63 - __builtin_clzll(groups);
+        full = Group(controls.data() + group * GROUP_WIDTH).matchFull();
+      }
+      return group * GROUP_WIDTH + 31 - __builtin_clz(full);
+    }
+
+    size_type nextFullSlot(size_type from) const
+    {
+      return nextFullSlot(from, capacity);
+    }
+  };
+
+  /* while the map grows in INCREMENTAL mode the elements are spread over two tables: new ones go to table,
+   * every modifying operation moves the next MIGRATION_STEP slots of oldTable there, until oldTable is empty and released
+   * slots are numbered 0 .. table.capacity - 1 in table, then table.capacity .. in oldTable */
+  Table table;
+  Table oldTable;
+  size_type migrationCursor = 0;                        // slots of oldTable before it are already moved
+  size_type firstOccupied = 0;                          // index of begin(), endIndex() if the map is empty
   size_type elementsInMap;
-  std::hash<key_type> GetNumberFromKey;
-  const double MAX_LOAD_FACTOR = 1.25; 
-  const size_type INITIAL_NUM_OF_BUCKETS = 32;
+  size_type growthLeft;                                 // inserts into EMPTY slots of table possible before the table is rebuilt
+  RehashMode rehashMode = STOP_THE_WORLD;
+  Hasher GetNumberFromKey;
+  KeyEqual keysEqual;
+  std::allocator<value_type> slotAllocator;
+
+  static constexpr size_type MIGRATION_STEP = 2 * GROUP_WIDTH;
 
-  size_type getIndexFromKey(const key_type& key) const
+  template <typename LookupKey>
+  size_type hashOf(const LookupKey& key) const
   {
-    return GetNumberFromKey(key) % numberOfBuckets;
+    return HashPolicy::mix(GetNumberFromKey(key));
   }
 
-  void rehash()
+  size_type endIndex() const
   {
-    size_type oldNumberOfBuckets = numberOfBuckets;
-    numberOfBuckets *= 2;
-    std::vector<bucket_list> newTableOfBuckets(numberOfBuckets);
-    for(size_type i = 0; i < oldNumberOfBuckets; i++)
+    return table.capacity + oldTable.capacity;
+  }
+
+  const value_type& slotAt(size_type index) const
+  {
+    return (index < table.capacity) ? table.slots[index] : oldTable.slots[index - table.capacity];
+  }
+
+  value_type& slotAt(size_type index)
+  {
+    return (index < table.capacity) ? table.slots[index] : oldTable.slots[index - table.capacity];
+  }
+
+  size_type firstFullSlot(size_type from) const
+  {
+    if(from < table.capacity)
+    {
+      size_type index = table.nextFullSlot(from);
+      if(index < table.capacity)
+        return index;
+      from = table.capacity;
+    }
+    return table.capacity + oldTable.nextFullSlot(from - table.capacity);
+  }
+
+  /* there has to be a full slot before index */
+  size_type lastFullSlotBefore(size_type index) const
+  {
+    if(index > table.capacity)
+    {
+      size_type oldIndex = oldTable.previousFullSlot(index - table.capacity);
+      if(oldIndex != oldTable.capacity)
+        return table.capacity + oldIndex;
+      index = table.capacity;
+    }
+    return table.previousFullSlot(index);
+  }
+
+  /* endIndex() if key isn't in the map */
+  template <typename LookupKey>
+  size_type findSlot(const LookupKey& key, size_type hash) const
+  {
+    size_type index = table.find(key, hash, keysEqual);
+    if(index != table.capacity)
+      return index;
+    return table.capacity + oldTable.find(key, hash, keysEqual);
+  }
+
+  /* slot for a new element in table, element has to be constructed there before commitInsert() */
+  size_type prepareInsert(size_type hash)
+  {
+    if(table.capacity == 0)
+      allocateTable(INITIAL_CAPACITY);
+    size_type index = table.findFreeSlot(hash);
+    if(growthLeft == 0 && table.controls[index] != DELETED)
+    {
+      size_type newCapacity = (elementsInMap < maxLoad(table.capacity) / 2) ? table.capacity : 2 * table.capacity;   // mostly DELETED slots, same size is enough
+      if(rehashMode == INCREMENTAL)
+        startMigration(newCapacity);
+      else
+        rehash(newCapacity);
+      index = table.findFreeSlot(hash);
+    }
+    return index;
+  }
+
+  void commitInsert(size_type index, size_type hash)
+  {
+    if(table.controls[index] == EMPTY)
+      --growthLeft;
+    table.setControl(index, tagOf(hash));
+    ++elementsInMap;
+    firstOccupied = std::min(firstOccupied, index);
+  }
+
+  /* slot of key and true if the element was constructed there from key and args, mapped value is built in place;
+   * key may refer to an element of oldTable (h[it->first]), so migration runs only after key was used, and a found
+   * element of oldTable is moved to table first, then the returned slot stays where it is */
+  template <typename KeyArgument, typename... Args>
+  std::pair<size_type, bool> tryEmplaceSlot(KeyArgument&& key, Args&&... args)
+  {
+    size_type hash = hashOf(key);
+    size_type index = findSlot(key, hash);
+    bool inserted = (index == endIndex());
+    if(inserted)
+    {
+      index = prepareInsert(hash);
+      ::new (static_cast<void*>(table.slots + index)) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<KeyArgument>(key)),
+                                                                 std::forward_as_tuple(std::forward<Args>(args)...));
+      commitInsert(index, hash);
+    }
+    else if(index >= table.capacity)
+      index = migrateSlot(index - table.capacity);
+    migrateStep();
+    return std::make_pair(index, inserted);
+  }
+
+  template <typename Pair>
+  struct IsPairWithKey : std::false_type
+  {};
+
+  template <typename First, typename Second>
+  struct IsPairWithKey<std::pair<First, Second>> : std::is_same<typename std::decay<First>::type, key_type>
+  {};
+
+  template <typename KeyArgument, typename MappedArgument,
+            typename = typename std::enable_if<std::is_same<typename std::decay<KeyArgument>::type, key_type>::value>::type>
+  std::pair<size_type, bool> emplaceSlot(KeyArgument&& key, MappedArgument&& value)
+  {
+    return tryEmplaceSlot(std::forward<KeyArgument>(key), std::forward<MappedArgument>(value));
+  }
+
+  template <typename Pair, typename = typename std::enable_if<IsPairWithKey<typename std::decay<Pair>::type>::value>::type>
+  std::pair<size_type, bool> emplaceSlot(Pair&& element)
+  {
+    return tryEmplaceSlot(std::get<0>(std::forward<Pair>(element)), std::get<1>(std::forward<Pair>(element)));
+  }
+
+  /* a const key can't be moved out of a built pair, so it is copied */
+  template <typename... Args>
+  std::pair<size_type, bool> emplaceSlot(Args&&... args)
+  {
+    static_assert(std::is_copy_constructible<key_type>::value,
+                  "emplace() copies the key unless it gets (key, value) or a pair holding key_type, pass one of them");
+    value_type element(std::forward<Args>(args)...);
+    return tryEmplaceSlot(element.first, std::move(element.second));
+  }
+
+  /* slot of table becomes EMPTY if no group containing it was ever seen full, otherwise probing could stop too early,
+   * slots of oldTable are always marked DELETED, it is never written to again */
+  void eraseSlot(size_type index)
+  {
+    --elementsInMap;
+    group_mask fullLeft;
+    if(index >= table.capacity)
     {
-      if(tableOfBuckets[i].size() != 0)
+      size_type oldIndex = index - table.capacity;
+      oldTable.slots[oldIndex].~value_type();
+      fullLeft = oldTable.releaseSlot(oldIndex, DELETED);
+    }
+    else
+    {
+      table.slots[index].~value_type();
+      size_type indexBefore = (index - GROUP_WIDTH) & (table.capacity - 1);
+      group_mask emptyAfter = Group(table.controls.data() + index).matchEmpty();
+      group_mask emptyBefore = Group(table.controls.data() + indexBefore).matchEmpty();
+      if(emptyAfter != 0 && emptyBefore != 0 &&
+         countTrailingZeros(emptyAfter) + __builtin_clz(emptyBefore << (32 - GROUP_WIDTH)) < GROUP_WIDTH)
       {
-        for(auto& item : tableOfBuckets[i])
-          newTableOfBuckets[getIndexFromKey(item.first)].push_back(item);
-      } 
+        fullLeft = table.releaseSlot(index, EMPTY);
+        ++growthLeft;
+      }
+      else
+        fullLeft = table.releaseSlot(index, DELETED);
+    }
+    if(index == firstOccupied)                          // both tables have a multiple of GROUP_WIDTH slots, groups don't cross them
+    {
+      group_mask fullAfter = fullLeft >> (index % GROUP_WIDTH);
+      firstOccupied = (fullAfter != 0) ? index + countTrailingZeros(fullAfter) : firstFullSlot((index | (GROUP_WIDTH - 1)) + 1);
+    }
+  }
+
+  void allocateTable(size_type tableCapacity)
+  {
+    table.capacity = tableCapacity;
+    table.controls.assign(tableCapacity + GROUP_WIDTH, EMPTY);
+    table.occupiedGroups.assign((tableCapacity / GROUP_WIDTH + 63) / 64, 0);
+    firstOccupied = endIndex();
+    table.slots = slotAllocator.allocate(tableCapacity);
+    growthLeft = maxLoad(tableCapacity);
+  }
+
+  void destroyTable(Table& toDestroy)
+  {
+    for(size_type i = toDestroy.nextFullSlot(0); i < toDestroy.capacity; i = toDestroy.nextFullSlot(i + 1))
+      toDestroy.slots[i].~value_type();
+    if(toDestroy.capacity != 0)
+      slotAllocator.deallocate(toDestroy.slots, toDestroy.capacity);
+    toDestroy = Table();
+  }
+
+  /* slot of table the element went to; the key is moved too, although it is const in the pair (the way
+   * std::map node handles hand it out), the old element is destroyed right after, so nobody sees it moved from;
+   * without it every relocation would copy keys and keys that can only be moved couldn't be stored at all */
+  size_type moveIntoTable(value_type& element)
+  {
+    size_type hash = hashOf(element.first);
+    size_type index = table.findFreeSlot(hash);
+    ::new (static_cast<void*>(table.slots + index)) value_type(std::move(const_cast<key_type&>(element.first)), std::move(element.second));
+    if(table.controls[index] == EMPTY)
+      --growthLeft;
+    table.setControl(index, tagOf(hash));
+    firstOccupied = std::min(firstOccupied, index);
+    element.~value_type();
+    return index;
+  }
+
+  /* moves one element of oldTable to table out of turn, returns its new slot */
+  size_type migrateSlot(size_type oldIndex)
+  {
+    size_type index = moveIntoTable(oldTable.slots[oldIndex]);
+    oldTable.releaseSlot(oldIndex, DELETED);
+    return index;
+  }
+
+  /* moves at most MIGRATION_STEP slots, so no operation pays for more than that */
+  void migrateStep()
+  {
+    if(oldTable.capacity == 0)
+      return;
+    size_type stepEnd = std::min(migrationCursor + MIGRATION_STEP, oldTable.capacity);
+    for(size_type i = oldTable.nextFullSlot(migrationCursor, stepEnd); i < stepEnd; i = oldTable.nextFullSlot(i + 1, stepEnd))
+      migrateSlot(i);
+    migrationCursor = stepEnd;
+    if(migrationCursor == oldTable.capacity)
+    {
+      destroyTable(oldTable);
+      firstOccupied = std::min(firstOccupied, endIndex());
+    }
+  }
+
+  void finishMigration()
+  {
+    while(oldTable.capacity != 0)
+      migrateStep();
+  }
+
+  /* table with room for all elements of oldTable: it is twice as big, or as big but half full, so it doesn't fill up
+   * before oldTable is emptied by one step per operation */
+  void startMigration(size_type newCapacity)
+  {
+    finishMigration();
+    oldTable = std::move(table);
+    migrationCursor = 0;
+    allocateTable(newCapacity);
+    firstOccupied = firstFullSlot(0);
+  }
+
+  void rehash(size_type newCapacity)
+  {
+    finishMigration();
+    Table previous = std::move(table);
+    allocateTable(newCapacity);
+    for(size_type i = previous.nextFullSlot(0); i < previous.capacity; i = previous.nextFullSlot(i + 1))
+      moveIntoTable(previous.slots[i]);
+    if(previous.capacity != 0)
+      slotAllocator.deallocate(previous.slots, previous.capacity);
+  }
+
+  /* copies slots to the same places, so nothing has to be hashed or probed again */
+  void cloneTable(Table& to, const Table& from)
+  {
+    if(from.capacity == 0)
+      return;
+    to.controls = from.controls;
+    to.occupiedGroups = from.occupiedGroups;
+    to.slots = slotAllocator.allocate(from.capacity);
+    to.capacity = from.capacity;
+    size_type i = from.nextFullSlot(0);
+    try
+    {
+      for(; i < from.capacity; i = from.nextFullSlot(i + 1))
+        ::new (static_cast<void*>(to.slots + i)) value_type(from.slots[i]);
+    }
+    catch(...)
+    {
+      for(size_type j = to.nextFullSlot(0); j < i; j = to.nextFullSlot(j + 1))
+        to.slots[j].~value_type();
+      slotAllocator.deallocate(to.slots, to.capacity);
+      to = Table();
+      throw;
     }
-    tableOfBuckets = std::move(newTableOfBuckets);
+  }
+
+  /* smallest table that takes elementsAmount elements without being rebuilt */
+  static size_type capacityFor(size_type elementsAmount)
+  {
+    size_type tableCapacity = INITIAL_CAPACITY;
+    while(elementsAmount > maxLoad(tableCapacity))
+      tableCapacity = 2 * tableCapacity;
+    return tableCapacity;
+  }
+
+  template <typename InputIterator>
+  void reserveFor(InputIterator first, InputIterator last, std::forward_iterator_tag)
+  {
+    reserve(getSize() + static_cast<size_type>(std::distance(first, last)));
+  }
+
+  template <typename InputIterator>
+  void reserveFor(InputIterator, InputIterator, std::input_iterator_tag)
+  {}
+
+  void swapContents(HashMap& other)
+  {
+    std::swap(table, other.table);
+    std::swap(oldTable, other.oldTable);
+    std::swap(migrationCursor, other.migrationCursor);
+    std::swap(firstOccupied, other.firstOccupied);
+    std::swap(elementsInMap, other.elementsInMap);
+    std::swap(growthLeft, other.growthLeft);
+    std::swap(rehashMode, other.rehashMode);
+    std::swap(GetNumberFromKey, other.GetNumberFromKey);
+    std::swap(keysEqual, other.keysEqual);
   }
 
 public:
+  /* table is allocated by the first insert or reserve(), so an empty map costs no allocation */
   HashMap()
   {
-    numberOfBuckets = INITIAL_NUM_OF_BUCKETS;
     elementsInMap = 0;
-    tableOfBuckets.resize(numberOfBuckets);
+    growthLeft = 0;
   }
 
-  HashMap(std::initializer_list<value_type> list)
+  explicit HashMap(const Hasher& hasher, const KeyEqual& keyEqual = KeyEqual()) : HashMap()
   {
-    elementsInMap = 0;
-    numberOfBuckets = INITIAL_NUM_OF_BUCKETS;
-    while(list.size() > numberOfBuckets)
-      numberOfBuckets = 2 * numberOfBuckets;
-    tableOfBuckets.resize(numberOfBuckets);
-    for(auto& item : list)
+    GetNumberFromKey = hasher;
+    keysEqual = keyEqual;
+  }
+
+  /* sized once for the whole range if its length is known, so inserting never rebuilds the table,
+   * a key repeated in the range gets the last of its values */
+  template <typename InputIterator>
+  HashMap(InputIterator first, InputIterator last) : HashMap()
+  {
+    insert(first, last);
+  }
+
+  HashMap(std::initializer_list<value_type> list) : HashMap(list.begin(), list.end())
+  {}
+
+  /* the copy has the same table layout, elements are copied slot by slot */
+  HashMap(const HashMap& other) : HashMap(other.GetNumberFromKey, other.keysEqual)
+  {
+    rehashMode = other.rehashMode;
+    cloneTable(table, other.table);
+    try
     {
-      tableOfBuckets[getIndexFromKey(item.first)].push_back(item);
-      ++elementsInMap;
+      cloneTable(oldTable, other.oldTable);
     }
+    catch(...)
+    {
+      destroyTable(table);
+      throw;
+    }
+    migrationCursor = other.migrationCursor;
+    firstOccupied = other.firstOccupied;
+    elementsInMap = other.elementsInMap;
+    growthLeft = other.growthLeft;
   }
 
-  HashMap(const HashMap& other)
+  /* takes the tables of other, which is left empty without a table */
+  HashMap(HashMap&& other) : HashMap()
   {
-    numberOfBuckets = INITIAL_NUM_OF_BUCKETS;
-    elementsInMap = 0;
-    tableOfBuckets.resize(numberOfBuckets);
-    for(auto iter = other.begin(); iter != other.end(); ++iter)
-      this->operator[](iter->first) = iter->second;
+    swapContents(other);
   }
 
-  HashMap(HashMap&& other)
+  ~HashMap()
   {
-    numberOfBuckets = INITIAL_NUM_OF_BUCKETS;
-    elementsInMap = 0;
-    tableOfBuckets.resize(numberOfBuckets);
-    std::swap(numberOfBuckets, other.numberOfBuckets);
-    std::swap(elementsInMap, other.elementsInMap);
-    std::swap(tableOfBuckets, other.tableOfBuckets);
+    destroyTable(table);
+    destroyTable(oldTable);
   }
 
   HashMap& operator=(const HashMap& other)
   {
     if(this == &other)
       return *this;
-    tableOfBuckets.clear();
-    elementsInMap = 0;
-    numberOfBuckets = other.numberOfBuckets;
-    tableOfBuckets.resize(numberOfBuckets);
-    for(auto iter = other.begin(); iter != other.end(); ++iter)
-      this->operator[](iter->first) = iter->second;
+    HashMap copy(other);
+    swapContents(copy);
     return *this;
   }
 
@@ -116,45 +805,126 @@ public:
   {
     if(this == &other)
       return *this;
-    tableOfBuckets.clear();
-    elementsInMap = 0;
-    numberOfBuckets = INITIAL_NUM_OF_BUCKETS;
-    tableOfBuckets.resize(numberOfBuckets);
-    std::swap(numberOfBuckets, other.numberOfBuckets);
-    std::swap(elementsInMap, other.elementsInMap);
-    std::swap(tableOfBuckets, other.tableOfBuckets);
+    HashMap taken(std::move(other));
+    swapContents(taken);
     return *this;
   }
 
+  /* makes room for elementsAmount elements, so inserting up to that many doesn't rebuild the table */
+  void reserve(size_type elementsAmount)
+  {
+    size_type tableCapacity = capacityFor(elementsAmount);
+    if(tableCapacity > table.capacity)
+      rehash(tableCapacity);
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last)
+  {
+    reserveFor(first, last, typename std::iterator_traits<InputIterator>::iterator_category());
+    for(; first != last; ++first)
+      this->operator[](first->first) = first->second;
+  }
+
   bool isEmpty() const
   {
     return elementsInMap == 0;
   }
 
+  void setRehashMode(RehashMode mode)
+  {
+    rehashMode = mode;
+    if(rehashMode == STOP_THE_WORLD)
+      finishMigration();
+  }
+
   mapped_type& operator[](const key_type& key)
   {
-    size_type index = getIndexFromKey(key);
-    if(!tableOfBuckets[index].empty())
-    {
-      for(auto iter = tableOfBuckets[index].begin(); iter != tableOfBuckets[index].end(); ++iter)
-      {
-        if((*iter).first == key)
-          return (*iter).second;
-      }
-      tableOfBuckets[index].emplace_back(value_type(key, mapped_type{}));
-      ++elementsInMap;
-      if(elementsInMap / static_cast<double>(numberOfBuckets > MAX_LOAD_FACTOR))
-        rehash();
-      return tableOfBuckets[getIndexFromKey(key)].back().second;
-    }
-    else
-    {
-      tableOfBuckets[index].emplace_front(value_type(key, mapped_type{}));
-        ++elementsInMap;
-        if((elementsInMap / static_cast<double>(numberOfBuckets)) > MAX_LOAD_FACTOR)
-          rehash();
-        return tableOfBuckets[getIndexFromKey(key)].begin()->second;
-    }
+    return slotAt(tryEmplaceSlot(key).first).second;
+  }
+
+  mapped_type& operator[](key_type&& key)
+  {
+    return slotAt(tryEmplaceSlot(std::move(key)).first).second;
+  }
+
+  /* inserts (key, mapped_type(args...)) if key is missing, otherwise leaves args untouched; second is true if it inserted */
+  template <typename... Args>
+  std::pair<iterator, bool> tryEmplace(const key_type& key, Args&&... args)
+  {
+    auto result = tryEmplaceSlot(key, std::forward<Args>(args)...);
+    return std::make_pair(Iterator(this, result.first), result.second);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> tryEmplace(key_type&& key, Args&&... args)
+  {
+    auto result = tryEmplaceSlot(std::move(key), std::forward<Args>(args)...);
+    return std::make_pair(Iterator(this, result.first), result.second);
+  }
+
+  /* inserts (key, value) or assigns value to the element already there; second is true if it inserted */
+  template <typename MappedArgument>
+  std::pair<iterator, bool> insertOrAssign(const key_type& key, MappedArgument&& value)
+  {
+    auto result = tryEmplaceSlot(key, std::forward<MappedArgument>(value));
+    if(!result.second)
+      slotAt(result.first).second = std::forward<MappedArgument>(value);
+    return std::make_pair(Iterator(this, result.first), result.second);
+  }
+
+  template <typename MappedArgument>
+  std::pair<iterator, bool> insertOrAssign(key_type&& key, MappedArgument&& value)
+  {
+    auto result = tryEmplaceSlot(std::move(key), std::forward<MappedArgument>(value));
+    if(!result.second)
+      slotAt(result.first).second = std::forward<MappedArgument>(value);
+    return std::make_pair(Iterator(this, result.first), result.second);
+  }
+
+  /* (key, value) or a pair whose first is key_type is inserted like tryEmplace(), so an rvalue key is moved in;
+   * for other arguments the element is built first to learn its key, which is then copied into the slot */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    auto result = emplaceSlot(std::forward<Args>(args)...);
+    return std::make_pair(Iterator(this, result.first), result.second);
+  }
+
+  /* find() and valueOf() also take any key type the hasher and key equality accept, if both of them declare is_transparent,
+   * e.g. const char* or std::string_view for std::string keys, so no temporary key is built */
+  template <typename LookupKey>
+  using transparent_key = typename std::enable_if<IsTransparent<Hasher>::value && IsTransparent<KeyEqual>::value &&
+                                                  !std::is_same<LookupKey, key_type>::value>::type;
+
+  template <typename LookupKey, typename = transparent_key<LookupKey>>
+  const mapped_type& valueOf(const LookupKey& key) const
+  {
+    auto iteratorToElement = find(key);
+    if(iteratorToElement == cend())
+      throw std::out_of_range("in function valueOf(const LookupKey&), cannot find value of invalid key");
+    return (*iteratorToElement).second;
+  }
+
+  template <typename LookupKey, typename = transparent_key<LookupKey>>
+  mapped_type& valueOf(const LookupKey& key)
+  {
+    auto iteratorToElement = find(key);
+    if(iteratorToElement == end())
+      throw std::out_of_range("in function valueOf(const LookupKey&), cannot find value of invalid key");
+    return (*iteratorToElement).second;
+  }
+
+  template <typename LookupKey, typename = transparent_key<LookupKey>>
+  const_iterator find(const LookupKey& key) const
+  {
+    return ConstIterator(this, findSlot(key, hashOf(key)));
+  }
+
+  template <typename LookupKey, typename = transparent_key<LookupKey>>
+  iterator find(const LookupKey& key)
+  {
+    return Iterator(this, findSlot(key, hashOf(key)));
   }
 
   const mapped_type& valueOf(const key_type& key) const
@@ -175,51 +945,29 @@ public:
 
   const_iterator find(const key_type& key) const
   {
-    size_type index = getIndexFromKey(key);
-    if(tableOfBuckets[index].empty())
-      return cend();
-    else
-    {
-      for(auto iter = tableOfBuckets[index].begin(); iter != tableOfBuckets[index].end(); ++iter)
-      {
-        if((*iter).first == key)
-          return ConstIterator(this, index, iter);
-      }
-      return cend();
-    }
+    return ConstIterator(this, findSlot(key, hashOf(key)));
   }
 
   iterator find(const key_type& key)
   {
-    size_type index = getIndexFromKey(key);
-    if(tableOfBuckets[index].empty())
-      return end();
-    else
-    {
-      for(auto iter = tableOfBuckets[index].begin(); iter != tableOfBuckets[index].end(); ++iter)
-      {
-        if((*iter).first == key)
-          return Iterator(this, index, iter);
-      }
-      return end();
-    }
+    return Iterator(this, findSlot(key, hashOf(key)));
   }
 
   void remove(const key_type& key)
   {
-    auto toRemove = find(key);
-    if(toRemove == end())
+    size_type index = findSlot(key, hashOf(key));
+    if(index == endIndex())
       throw std::out_of_range("in function: remove(const const_iterator&), cannot remove non-existing element");
-    tableOfBuckets[toRemove.bucketIndex].erase(toRemove.bucketListConstIterator);
-    --elementsInMap;
+    eraseSlot(index);
+    migrateStep();
   }
 
   void remove(const const_iterator& it)
   {
     if(it == end())
       throw std::out_of_range("in function: remove(const const_iterator&), cannot remove end()");
-    tableOfBuckets[it.bucketIndex].erase(it.bucketListConstIterator);
-    --elementsInMap;
+    eraseSlot(it.slotIndex);
+    migrateStep();
   }
 
   size_type getSize() const
@@ -227,18 +975,16 @@ public:
     return elementsInMap;
   }
 
+  /* maps are equal if they hold the same pairs, no matter in which order they were inserted */
   bool operator==(const HashMap& other) const
   {
     if(elementsInMap != other.elementsInMap)
       return false;
-    auto thisMap = cbegin();
-    auto otherMap = other.cbegin();
-    while(thisMap != cend() && otherMap != other.cend())
+    for(auto thisMap = cbegin(); thisMap != cend(); ++thisMap)
     {
-      if((*thisMap).first != (*otherMap).first || (*thisMap).second != (*otherMap).second)
+      auto otherMap = other.find((*thisMap).first);
+      if(otherMap == other.cend() || (*otherMap).second != (*thisMap).second)
         return false;
-      ++thisMap;
-      ++otherMap;
     }
     return true;
   }
@@ -250,40 +996,22 @@ public:
 
   iterator begin()
   {
-    if(isEmpty())
-      return end();
-    size_type index = 0;
-    while(index < numberOfBuckets)
-    {
-      if(!tableOfBuckets[index].empty())
-        break;
-      ++index;
-    }
-    return Iterator(this, index, tableOfBuckets[index].begin());
+    return Iterator(this, firstOccupied);
   }
 
   iterator end()
   {
-    return Iterator(this, numberOfBuckets - 1, tableOfBuckets[numberOfBuckets - 1].end());
+    return Iterator(this, endIndex());
   }
 
   const_iterator cbegin() const
   {
-    if(isEmpty())
-      return cend();
-    size_type index = 0;
-    while(index < numberOfBuckets)
-    {
-      if(!tableOfBuckets[index].empty())
-        break;
-      ++index;
-    }
-    return ConstIterator(this, index, tableOfBuckets[index].begin());
+    return ConstIterator(this, firstOccupied);
   }
 
   const_iterator cend() const
   {
-    return ConstIterator(this, numberOfBuckets - 1, tableOfBuckets[numberOfBuckets - 1].end());
+    return ConstIterator(this, endIndex());
   }
 
   const_iterator begin() const
@@ -297,129 +1025,74 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Hasher, typename KeyEqual, typename HashPolicy>
+class HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::ConstIterator
 {
 public:
   using reference = typename HashMap::const_reference;
   using iterator_category = std::bidirectional_iterator_tag;
   using value_type = typename HashMap::value_type;
+  using difference_type = std::ptrdiff_t;
   using pointer = const typename HashMap::value_type*;
-  using list_iterator = typename HashMap::bucket_list::const_iterator;
 
 private:
   const HashMap* map_ptr;
-  HashMap::size_type bucketIndex;
-  list_iterator bucketListConstIterator;
-  friend class HashMap<KeyType, ValueType>;
+  HashMap::size_type slotIndex;                          // map_ptr->endIndex() for end()
+  friend class HashMap;
 
   bool pointsAtBeginning() const
   {
-    return (bucketIndex == 0 &&  bucketListConstIterator == map_ptr->tableOfBuckets[bucketIndex].begin());
+    return slotIndex == map_ptr->firstOccupied;
   }
 
   bool pointsAtEnd() const
   {
-    return (map_ptr->numberOfBuckets == bucketIndex + 1 &&  bucketListConstIterator == map_ptr->tableOfBuckets[bucketIndex].end());
+    return slotIndex == map_ptr->endIndex();
+  }
+
+  void moveForward()
+  {
+    slotIndex = map_ptr->firstFullSlot(slotIndex + 1);
+  }
+
+  void moveBackward()
+  {
+    slotIndex = map_ptr->lastFullSlotBefore(slotIndex);
   }
 
 public:
-  explicit ConstIterator(const HashMap<KeyType, ValueType>* map, HashMap::size_type bucketIdx, list_iterator listConstIterator) : map_ptr(map), 
-                                                                                    bucketIndex(bucketIdx), bucketListConstIterator(listConstIterator)
+  explicit ConstIterator(const HashMap* map, HashMap::size_type slotIdx) : map_ptr(map), slotIndex(slotIdx)
   {}
 
   ConstIterator(const ConstIterator& other)
   {
     map_ptr = other.map_ptr;
-    bucketIndex = other.bucketIndex;
-    bucketListConstIterator = other.bucketListConstIterator;
+    slotIndex = other.slotIndex;
   }
 
   ConstIterator& operator++()
   {
     if(map_ptr->isEmpty() || pointsAtEnd())
       throw std::out_of_range("in function: operator++(), cannot increment end() or empty map");
-    auto lastOfList = --map_ptr->tableOfBuckets[bucketIndex].end();
-    if(bucketListConstIterator == lastOfList)
-    {
-      do
-      {
-        ++bucketIndex;
-        if(!map_ptr->tableOfBuckets[bucketIndex].empty())
-        {
-          bucketListConstIterator = map_ptr->tableOfBuckets[bucketIndex].begin();
-          return *this;
-        }
-        if(map_ptr->numberOfBuckets == bucketIndex + 1)
-        {
-          bucketListConstIterator = map_ptr->tableOfBuckets[bucketIndex].end();
-          return *this;
-        }
-      } while(true);
-    }
-    else
-    {
-      ++bucketListConstIterator;
-      return *this;
-    }
+    moveForward();
+    return *this;
   }
 
   ConstIterator operator++(int)
   {
     if(map_ptr->isEmpty() || pointsAtEnd())
       throw std::out_of_range("in function: operator++(int), cannot increment end() or empty map");
-    auto lastOfList = --map_ptr->tableOfBuckets[bucketIndex].end();
     auto temp(*this);
-    if(bucketListConstIterator == lastOfList)
-    {
-      do
-      {
-        ++bucketIndex;
-        if(!map_ptr->tableOfBuckets[bucketIndex].empty())
-        {
-          bucketListConstIterator = map_ptr->tableOfBuckets[bucketIndex].begin();
-          return temp;
-        }
-        if(map_ptr->numberOfBuckets == bucketIndex + 1)
-        {
-          bucketListConstIterator = map_ptr->tableOfBuckets[bucketIndex].end();
-          return temp;
-        }
-      } while(true);
-    }
-    else
-    {
-      ++bucketListConstIterator;
-      return temp;
-    }
+    moveForward();
+    return temp;
   }
 
   ConstIterator& operator--()
   {
     if(map_ptr->isEmpty() || pointsAtBeginning())
       throw std::out_of_range("in function: operator--(), cannot decrement begin() or empty map");
-    if(bucketListConstIterator == map_ptr->tableOfBuckets[bucketIndex].begin())
-    {
-      do
-      {
-        --bucketIndex;
-        if(!map_ptr->tableOfBuckets[bucketIndex].empty())
-        {
-          bucketListConstIterator = --(map_ptr->tableOfBuckets[bucketIndex].end());
-          return *this;
-        }
-        if(bucketIndex == 0)
-        {
-          bucketListConstIterator = map_ptr->tableOfBuckets[bucketIndex].begin();
-          return *this;
-        }
-      } while(true);
-    }
-    else
-    {
-      --bucketListConstIterator;
-      return *this;
-    }
+    moveBackward();
+    return *this;
   }
 
   ConstIterator operator--(int)
@@ -427,35 +1100,15 @@ public:
     if(map_ptr->isEmpty() || pointsAtBeginning())
       throw std::out_of_range("in function: operator--(int), cannot decrement begin() or empty map");
     auto temp(*this);
-    if(bucketListConstIterator == map_ptr->tableOfBuckets[bucketIndex].begin())
-    {
-      do
-      {
-        --bucketIndex;
-        if(!map_ptr->tableOfBuckets[bucketIndex].empty())
-        {
-          bucketListConstIterator = --(map_ptr->tableOfBuckets[bucketIndex].end());
-          return *this;
-        }
-        if(bucketIndex == 0)
-        {
-          bucketListConstIterator = map_ptr->tableOfBuckets[bucketIndex].begin();
-          return *this;
-        }
-      } while(true);
-    }
-    else
-    {
-      --bucketListConstIterator;
-      return *this;
-    }
+    moveBackward();
+    return temp;
   }
 
   reference operator*() const
   {
     if(pointsAtEnd())
       throw std::out_of_range("in function: operator*(), cannot dereference end()");
-    return *bucketListConstIterator;
+    return map_ptr->slotAt(slotIndex);
   }
 
   pointer operator->() const
@@ -465,7 +1118,7 @@ public:
 
   bool operator==(const ConstIterator& other) const
   {
-    return (bucketIndex == other.bucketIndex && bucketListConstIterator == other.bucketListConstIterator);
+    return (map_ptr == other.map_ptr && slotIndex == other.slotIndex);
   }
 
   bool operator!=(const ConstIterator& other) const
@@ -474,16 +1127,15 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class HashMap<KeyType, ValueType>::Iterator : public HashMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Hasher, typename KeyEqual, typename HashPolicy>
+class HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::Iterator : public HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::ConstIterator
 {
 public:
   using reference = typename HashMap::reference;
   using pointer = typename HashMap::value_type*;
-  using list_iterator = typename HashMap::bucket_list::iterator;
 
 
-  explicit Iterator(const HashMap<KeyType, ValueType>* map, size_t bucketIdx, list_iterator listConstIterator) : ConstIterator(map, bucketIdx, listConstIterator)
+  explicit Iterator(const HashMap* map, size_t slotIdx) : ConstIterator(map, slotIdx)
   {}
 
   Iterator(const ConstIterator& other)
@@ -528,6 +1180,17 @@ public:
   }
 };
 
+template <typename KeyType, typename ValueType, typename Hasher, typename KeyEqual, typename HashPolicy>
+constexpr typename HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::control_type HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::EMPTY;
+template <typename KeyType, typename ValueType, typename Hasher, typename KeyEqual, typename HashPolicy>
+constexpr typename HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::control_type HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::DELETED;
+template <typename KeyType, typename ValueType, typename Hasher, typename KeyEqual, typename HashPolicy>
+constexpr typename HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::size_type HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::GROUP_WIDTH;
+template <typename KeyType, typename ValueType, typename Hasher, typename KeyEqual, typename HashPolicy>
+constexpr typename HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::size_type HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::INITIAL_CAPACITY;
+template <typename KeyType, typename ValueType, typename Hasher, typename KeyEqual, typename HashPolicy>
+constexpr typename HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::size_type HashMap<KeyType, ValueType, Hasher, KeyEqual, HashPolicy>::MIGRATION_STEP;
+
 }
 
 #endif /* AISDI_MAPS_HASHMAP_H */
@@ -0,0 +1,160 @@
+#ifndef AISDI_MAPS_NODEPOOL_H
+#define AISDI_MAPS_NODEPOOL_H
+
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+namespace aisdi
+{
+
+/* allocator handing out single objects from large chunks: a freed object goes to a free list and is given out again
+ * in O(1), release() returns all chunks at once; allocations of more than one object go to operator new
+ * it is meant for one node based container: every copy starts with its own empty pool and two pools are equal
+ * only if they are the same object, so nodes never move between pools except when the whole pool is moved */
+template <typename T>
+class NodePool
+{
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  template <typename U>
+  struct rebind
+  {
+    using other = NodePool<U>;
+  };
+
+private:
+  union Slot
+  {
+    Slot* next;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  static constexpr size_type FIRST_CHUNK_SIZE = 32;
+  static constexpr size_type MAX_CHUNK_SIZE = 1 << 16;  // slots, chunks grow twice up to it
+
+  std::vector<std::unique_ptr<Slot[]>> chunks;
+  Slot* freeList = nullptr;
+  Slot* chunkPosition = nullptr;                        // slots from chunkPosition to chunkEnd were never given out
+  Slot* chunkEnd = nullptr;
+  size_type nextChunkSize = FIRST_CHUNK_SIZE;
+
+  void addChunk()
+  {
+    chunks.emplace_back(new Slot[nextChunkSize]);
+    chunkPosition = chunks.back().get();
+    chunkEnd = chunkPosition + nextChunkSize;
+    if(nextChunkSize < MAX_CHUNK_SIZE)
+      nextChunkSize *= 2;
+  }
+
+public:
+  NodePool() = default;
+
+  NodePool(const NodePool&) : NodePool()
+  {}
+
+  template <typename U>
+  NodePool(const NodePool<U>&) : NodePool()
+  {}
+
+  NodePool(NodePool&& other)
+  {
+    swap(other);
+  }
+
+  NodePool& operator=(NodePool&& other)
+  {
+    if(this == &other)
+      return *this;
+    NodePool taken(std::move(other));
+    swap(taken);
+    return *this;
+  }
+
+  NodePool& operator=(const NodePool&) = delete;
+
+  NodePool select_on_container_copy_construction() const
+  {
+    return NodePool();
+  }
+
+  T* allocate(size_type amount)
+  {
+    if(amount != 1)
+      return static_cast<T*>(::operator new(amount * sizeof(T)));
+    Slot* slot = freeList;
+    if(slot != nullptr)
+      freeList = slot->next;
+    else
+    {
+      if(chunkPosition == chunkEnd)
+        addChunk();
+      slot = chunkPosition++;
+    }
+    return reinterpret_cast<T*>(slot);
+  }
+
+  void deallocate(T* object, size_type amount)
+  {
+    if(amount != 1)
+    {
+      ::operator delete(object);
+      return;
+    }
+    Slot* slot = reinterpret_cast<Slot*>(object);
+    slot->next = freeList;
+    freeList = slot;
+  }
+
+  /* frees memory of every object given out by this pool, objects have to be destroyed before if they need it */
+  void release()
+  {
+    chunks.clear();
+    freeList = chunkPosition = chunkEnd = nullptr;
+    nextChunkSize = FIRST_CHUNK_SIZE;
+  }
+
+  void swap(NodePool& other)
+  {
+    std::swap(chunks, other.chunks);
+    std::swap(freeList, other.freeList);
+    std::swap(chunkPosition, other.chunkPosition);
+    std::swap(chunkEnd, other.chunkEnd);
+    std::swap(nextChunkSize, other.nextChunkSize);
+  }
+
+  bool operator==(const NodePool& other) const
+  {
+    return this == &other;
+  }
+
+  bool operator!=(const NodePool& other) const
+  {
+    return this != &other;
+  }
+};
+
+template <typename T>
+constexpr typename NodePool<T>::size_type NodePool<T>::FIRST_CHUNK_SIZE;
+
+template <typename T>
+constexpr typename NodePool<T>::size_type NodePool<T>::MAX_CHUNK_SIZE;
+
+template <typename T>
+void swap(NodePool<T>& first, NodePool<T>& second)
+{
+  first.swap(second);
+}
+
+}
+
+#endif /* AISDI_MAPS_NODEPOOL_H */
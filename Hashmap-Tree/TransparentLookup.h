@@ -0,0 +1,42 @@
+#ifndef AISDI_MAPS_TRANSPARENTLOOKUP_H
+#define AISDI_MAPS_TRANSPARENTLOOKUP_H
+
+#include <string>
+#include <type_traits>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace aisdi
+{
+
+/* ordered maps compare a lookup key of another type with their keys directly only when the pair is marked here,
+ * which promises that ==, < and > give the same answers as converting the lookup key to KeyType first;
+ * any other type (numbers too, a size_t compared with an int key goes the wrong way for negative keys)
+ * is converted to KeyType before the lookup; specialize it to opt in for own types */
+template <typename KeyType, typename LookupKey, typename = void>
+struct IsTransparentLookup : std::false_type
+{};
+
+template <>
+struct IsTransparentLookup<std::string, const char*> : std::true_type
+{};
+
+template <>
+struct IsTransparentLookup<std::string, char*> : std::true_type
+{};
+
+#if __cplusplus >= 201703L
+template <>
+struct IsTransparentLookup<std::string, std::string_view> : std::true_type
+{};
+#endif
+
+/* enables lookup overloads taking LookupKey, string literals decay to const char* */
+template <typename KeyType, typename LookupKey>
+using transparent_lookup_key = typename std::enable_if<!std::is_same<LookupKey, KeyType>::value &&
+                                                       IsTransparentLookup<KeyType, typename std::decay<LookupKey>::type>::value>::type;
+
+}
+
+#endif /* AISDI_MAPS_TRANSPARENTLOOKUP_H */
@@ -5,11 +5,22 @@
 #include <initializer_list>
 #include <stdexcept>
 #include <utility>
+#include <type_traits>
+#include <tuple>
+#include <memory>
+#include <iterator>
+
+#include "NodePool.h"
+#include "TransparentLookup.h"
 
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
+/* nodes are allocated by Allocator rebound to the node type, by default each tree has its own NodePool
+ * with OrderStatistics every node also keeps the size of its subtree, which gives select() and rank() in O(log n)
+ * for one more word per node and a walk up to the root on every insertion and removal */
+template <typename KeyType, typename ValueType, typename Allocator = NodePool<std::pair<const KeyType, ValueType>>,
+          bool OrderStatistics = false>
 class TreeMap
 {
 public:
@@ -19,6 +30,7 @@ public:
   using size_type = std::size_t;
   using reference = value_type&;
   using const_reference = const value_type&;
+  using allocator_type = Allocator;
 
   class ConstIterator;
   class Iterator;
@@ -26,7 +38,30 @@ public:
   using const_iterator = ConstIterator;
 private:
 
-  class Node
+  /* number of nodes in the subtree, present only in trees with order statistics */
+  template <bool Counted, typename Unused = void>
+  class SubtreeSize
+  {
+  public:
+    template <typename NodeType>
+    void assignNewSize(const NodeType*, const NodeType*)
+    {}
+  };
+
+  template <typename Unused>
+  class SubtreeSize<true, Unused>
+  {
+  public:
+    size_type subtreeSize = 1;
+
+    template <typename NodeType>
+    void assignNewSize(const NodeType* left, const NodeType* right)
+    {
+      subtreeSize = 1 + ((left != nullptr) ? left->subtreeSize : 0) + ((right != nullptr) ? right->subtreeSize : 0);
+    }
+  };
+
+  class Node : public SubtreeSize<OrderStatistics>
   {
   public:
     Node* parent;
@@ -35,12 +70,15 @@ private:
     value_type data;
     size_type height;
 
-    Node(key_type key, mapped_type value, Node* prnt = nullptr) : parent(prnt), data(key, value)
+    /* data is constructed in place from args */
+    template <typename... Args>
+    explicit Node(Node* prnt, Args&&... args) : parent(prnt), data(std::forward<Args>(args)...)
     {
       leftChild = rightChild = nullptr;
       height = 1;
     }
 
+    /* subtree size too, when it is kept */
     void assignNewHeight()
     {
       size_type leftHeight = (leftChild != nullptr) ? leftChild->height : 0;
@@ -49,32 +87,174 @@ private:
         height = 1 + leftHeight;
       else
         height = 1 + rightHeight;
+      this->assignNewSize(leftChild, rightChild);
     }
 
   };
 
+  using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+  using node_traits = std::allocator_traits<node_allocator>;
+
   Node* root;
   size_type size;
+  node_allocator nodeAllocator;
+
+  template <typename... Args>
+  Node* createNode(Args&&... args)
+  {
+    Node* node = node_traits::allocate(nodeAllocator, 1);
+    try
+    {
+      node_traits::construct(nodeAllocator, node, std::forward<Args>(args)...);
+    }
+    catch(...)
+    {
+      node_traits::deallocate(nodeAllocator, node, 1);
+      throw;
+    }
+    return node;
+  }
+
+  void destroyNode(Node* node)
+  {
+    node_traits::destroy(nodeAllocator, node);
+    node_traits::deallocate(nodeAllocator, node, 1);
+  }
 
+  /* allocators with release() (like NodePool) free all nodes at once, true if it was done */
+  template <typename PoolAllocator>
+  static auto releaseAllNodes(PoolAllocator& pool, int) -> decltype(pool.release(), bool())
+  {
+    pool.release();
+    return true;
+  }
+
+  template <typename PoolAllocator>
+  static bool releaseAllNodes(PoolAllocator&, long)
+  {
+    return false;
+  }
+
+  /* the whole subtree goes away without recursion or extra memory: while the top node has a left child it is rotated
+   * right (only child links change, parents don't matter any more), so the top node has no smaller keys below it
+   * and can be freed, its right child becomes the new top; every node goes down at most once, so it is O(n) */
   void deleteNodesFrom(Node* startFrom)
   {
-    if(startFrom == nullptr)
-      return;
-    if(startFrom != root)
+    Node* top = startFrom;
+    while(top != nullptr)
     {
-      if(startFrom->parent->leftChild == startFrom)
-        startFrom->parent->leftChild = nullptr;
-      else  
-        startFrom->parent->rightChild = nullptr;
+      Node* left = top->leftChild;
+      if(left != nullptr)
+      {
+        top->leftChild = left->rightChild;
+        left->rightChild = top;
+        top = left;
+      }
+      else
+      {
+        Node* right = top->rightChild;
+        destroyNode(top);
+        top = right;
+      }
     }
-    deleteNodesFrom(startFrom->rightChild);
-    deleteNodesFrom(startFrom->leftChild);
-    delete startFrom;
   }
 
+  void attachChildren(Node* node, Node* left, Node* right)
+  {
+    node->leftChild = left;
+    node->rightChild = right;
+    if(left != nullptr)
+      left->parent = node;
+    if(right != nullptr)
+      right->parent = node;
+  }
+
+  /* copy of the subtree with the same shape, nothing is compared or rotated */
+  Node* cloneSubtree(const Node* from)
+  {
+    if(from == nullptr)
+      return nullptr;
+    Node* node = createNode(nullptr, from->data);
+    try
+    {
+      attachChildren(node, cloneSubtree(from->leftChild), nullptr);
+      attachChildren(node, node->leftChild, cloneSubtree(from->rightChild));
+    }
+    catch(...)
+    {
+      deleteNodesFrom(node);
+      throw;
+    }
+    node->assignNewHeight();
+    return node;
+  }
+
+  /* balanced subtree of the next amount elements of a sorted range, middle one becomes its root,
+   * subtrees differ in size by at most one, so heights differ by at most one too */
+  template <typename ForwardIterator>
+  Node* buildBalanced(ForwardIterator& position, size_type amount)
+  {
+    if(amount == 0)
+      return nullptr;
+    size_type leftAmount = (amount - 1) / 2;
+    Node* left = buildBalanced(position, leftAmount);
+    Node* node;
+    try
+    {
+      node = createNode(nullptr, *position);
+    }
+    catch(...)
+    {
+      deleteNodesFrom(left);
+      throw;
+    }
+    ++position;
+    attachChildren(node, left, nullptr);
+    try
+    {
+      attachChildren(node, left, buildBalanced(position, amount - 1 - leftAmount));
+    }
+    catch(...)
+    {
+      deleteNodesFrom(node);
+      throw;
+    }
+    node->assignNewHeight();
+    return node;
+  }
+
+  /* keys strictly increasing: tree is built in one pass, otherwise elements are inserted one by one */
+  template <typename ForwardIterator>
+  void buildFrom(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag)
+  {
+    size_type amount = 0;
+    for(ForwardIterator current = first, previous = first; current != last; previous = current, ++current, ++amount)
+    {
+      if(amount != 0 && !(current->first > previous->first))
+      {
+        buildFrom(first, last, std::input_iterator_tag());
+        return;
+      }
+    }
+    root = buildBalanced(first, amount);
+    size = amount;
+  }
+
+  template <typename InputIterator>
+  void buildFrom(InputIterator first, InputIterator last, std::input_iterator_tag)
+  {
+    for(; first != last; ++first)
+      this->operator[](first->first) = first->second;
+  }
+
+  /* nodes that need no destructor aren't visited at all when the allocator can free them in one step */
   void clearTree()
   {
-    deleteNodesFrom(root);
+    if(!std::is_trivially_destructible<value_type>::value || !releaseAllNodes(nodeAllocator, 0))
+    {
+      deleteNodesFrom(root);
+      releaseAllNodes(nodeAllocator, 0);
+    }
     size = 0;
     root = nullptr;
   }
@@ -135,10 +315,13 @@ private:
     rightRotate(grandparent);
   }
 
+  /* fixes heights from node up, rotating where subtrees differ by two; a subtree whose height didn't change can't
+   * unbalance its ancestors, so without subtree sizes the walk stops there, with them it goes on to the root */
   void rebalanceTree(Node* node)
   {
     while(node != nullptr)
     {
+      size_type oldHeight = node->height;
       node->assignNewHeight();
       size_type rightChildHeight = node->rightChild ? node->rightChild->height : 0;
       size_type leftChildHeight = node->leftChild ? node->leftChild->height : 0;
@@ -146,60 +329,289 @@ private:
       {
         size_type rightGrandchildHeight = node->rightChild->rightChild ? node->rightChild->rightChild->height : 0;
         size_type leftGrandchildHeight = node->rightChild->leftChild ? node->rightChild->leftChild->height : 0;
-        if(rightGrandchildHeight > leftGrandchildHeight)
-        {
+        if(rightGrandchildHeight >= leftGrandchildHeight)
           leftRotate(node);
-          return;
-        }
         else
-        {
           rightLeftRotate(node);
-          return;
-        }
+        node = node->parent;
       }
       else if(leftChildHeight > rightChildHeight + 1)
       {
         size_type rightGrandchildHeight = node->leftChild->rightChild ? node->leftChild->rightChild->height : 0;
         size_type leftGrandchildHeight = node->leftChild->leftChild ? node->leftChild->leftChild->height : 0;
-        if(leftGrandchildHeight > rightGrandchildHeight)
-        {
+        if(leftGrandchildHeight >= rightGrandchildHeight)
           rightRotate(node);
-          return;
-        }
         else
-        {
           leftRightRotate(node);
-          return;
-        }
+        node = node->parent;
       }
+      if(!OrderStatistics && node->height == oldHeight)
+        return;
       node = node->parent;
     }
   }
 
+  /* child of parent (or root) becomes newChild */
+  void replaceChild(Node* parent, Node* child, Node* newChild)
+  {
+    if(parent == nullptr)
+      root = newChild;
+    else if(parent->leftChild == child)
+      parent->leftChild = newChild;
+    else
+      parent->rightChild = newChild;
+    if(newChild != nullptr)
+      newChild->parent = parent;
+  }
+
+  static size_type subtreeSizeOf(const Node* node)
+  {
+    return (node != nullptr) ? node->subtreeSize : 0;
+  }
+
+  template <typename LookupKey>
+  size_type rankOf(const LookupKey& key) const
+  {
+    size_type smaller = 0;
+    Node* current = root;
+    while(current != nullptr)
+    {
+      if(key > current->data.first)
+      {
+        smaller += subtreeSizeOf(current->leftChild) + 1;
+        current = current->rightChild;
+      }
+      else
+        current = current->leftChild;
+    }
+    return smaller;
+  }
+
+  /* k-th node in order, counting from 0, k has to be less than size */
+  Node* selectNode(size_type k) const
+  {
+    Node* current = root;
+    while(true)
+    {
+      size_type leftSize = subtreeSizeOf(current->leftChild);
+      if(k == leftSize)
+        return current;
+      if(k < leftSize)
+        current = current->leftChild;
+      else
+      {
+        k -= leftSize + 1;
+        current = current->rightChild;
+      }
+    }
+  }
+
+  /* node with key, or nullptr and the place where such node would be attached */
+  Node* findPlace(const key_type& key, Node*& parent, bool& isRightChild) const
+  {
+    Node* current = root;
+    parent = nullptr;
+    while(current != nullptr)
+    {
+      if(key == current->data.first)
+        return current;
+      parent = current;
+      isRightChild = key > current->data.first;
+      current = isRightChild ? current->rightChild : current->leftChild;
+    }
+    return nullptr;
+  }
+
+  void linkNode(Node* newElement, Node* parent, bool isRightChild)
+  {
+    newElement->parent = parent;
+    if(parent == nullptr)
+      root = newElement;
+    else if(isRightChild)
+      parent->rightChild = newElement;
+    else
+      parent->leftChild = newElement;
+    ++size;
+    rebalanceTree(parent);
+  }
+
+  /* place is found before key is moved into the new node */
+  template <typename KeyArgument, typename... Args>
+  Node* tryEmplaceNode(KeyArgument&& key, Args&&... args)
+  {
+    Node* parent = nullptr;
+    bool isRightChild = false;
+    Node* existing = findPlace(key, parent, isRightChild);
+    if(existing != nullptr)
+      return existing;
+    Node* newElement = createNode(parent, std::piecewise_construct, std::forward_as_tuple(std::forward<KeyArgument>(key)),
+                                  std::forward_as_tuple(std::forward<Args>(args)...));
+    linkNode(newElement, parent, isRightChild);
+    return newElement;
+  }
+
+  /* nullptr if there is no such key */
+  template <typename LookupKey>
+  Node* findNode(const LookupKey& key) const
+  {
+    Node* temp = root;
+    while(temp != nullptr && temp->data.first != key)
+    {
+      if(key > temp->data.first)
+        temp = temp->rightChild;
+      else if(key < temp->data.first)
+        temp = temp->leftChild;
+    }
+    return temp;
+  }
+
+  /* nullptr if the tree is empty */
+  Node* leftmostNode() const
+  {
+    Node* node = root;
+    if(node != nullptr)
+      while(node->leftChild != nullptr)
+        node = node->leftChild;
+    return node;
+  }
+
+  /* in-order successor, nullptr after the last node */
+  static Node* nextNode(Node* node)
+  {
+    if(node->rightChild != nullptr)
+    {
+      node = node->rightChild;
+      while(node->leftChild != nullptr)
+        node = node->leftChild;
+      return node;
+    }
+    while(node->parent != nullptr && node->parent->rightChild == node)
+      node = node->parent;
+    return node->parent;
+  }
+
+  /* first node with key not less than key, nullptr if there is none */
+  template <typename LookupKey>
+  Node* lowerBoundNode(const LookupKey& key) const
+  {
+    Node* result = nullptr;
+    Node* current = root;
+    while(current != nullptr)
+    {
+      if(key > current->data.first)
+        current = current->rightChild;
+      else
+      {
+        result = current;
+        current = current->leftChild;
+      }
+    }
+    return result;
+  }
+
+  /* first node with key greater than key, nullptr if there is none */
+  template <typename LookupKey>
+  Node* upperBoundNode(const LookupKey& key) const
+  {
+    Node* result = nullptr;
+    Node* current = root;
+    while(current != nullptr)
+    {
+      if(key < current->data.first)
+      {
+        result = current;
+        current = current->leftChild;
+      }
+      else
+        current = current->rightChild;
+    }
+    return result;
+  }
+
+  /* node with key is the lower bound, the upper bound is then its successor, so one descent is enough */
+  template <typename LookupKey>
+  std::pair<Node*, Node*> equalRangeNodes(const LookupKey& key) const
+  {
+    Node* lower = lowerBoundNode(key);
+    if(lower == nullptr || key < lower->data.first)
+      return std::make_pair(lower, lower);
+    return std::make_pair(lower, nextNode(lower));
+  }
+
+  /* nodes of [first, last), last is searched only if the range is not empty */
+  template <typename FirstKey, typename LastKey>
+  std::pair<Node*, Node*> rangeNodes(const FirstKey& first, const LastKey& last) const
+  {
+    Node* begin = lowerBoundNode(first);
+    if(begin == nullptr || !(last > begin->data.first))
+      return std::make_pair(begin, begin);
+    return std::make_pair(begin, lowerBoundNode(last));
+  }
+
 public:
+  /* elements with keys from [first, last) of a map, nothing is copied: it is a pair of iterators found in O(log n),
+   * walking it costs O(k) for k elements; like any iterator it is invalidated by removing its elements */
+  template <typename RangeIterator>
+  class RangeView
+  {
+    RangeIterator first;
+    RangeIterator last;
+
+  public:
+    RangeView(const RangeIterator& from, const RangeIterator& to) : first(from), last(to)
+    {}
+
+    RangeIterator begin() const
+    {
+      return first;
+    }
+
+    RangeIterator end() const
+    {
+      return last;
+    }
+
+    bool isEmpty() const
+    {
+      return first == last;
+    }
+  };
+
+  using range_view = RangeView<iterator>;
+  using const_range_view = RangeView<const_iterator>;
+
   TreeMap()
   {
     root = nullptr;
     size = 0;
   }
 
-  TreeMap(std::initializer_list<value_type> list)
+  explicit TreeMap(const Allocator& allocator) : nodeAllocator(allocator)
   {
     root = nullptr;
     size = 0;
-    for(auto &item : list)
-      this->operator[](item.first) = item.second;
   }
 
-  TreeMap(const TreeMap& other)
+  /* sorted range of known length is built into a balanced tree in linear time, without rotations,
+   * any other range is inserted element by element, a repeated key gets the last of its values */
+  template <typename InputIterator>
+  TreeMap(InputIterator first, InputIterator last) : TreeMap()
   {
-    root = nullptr;
-    size = 0;
-    for(auto &item : other)
-      this->operator[](item.first) = item.second;
+    buildFrom(first, last, typename std::iterator_traits<InputIterator>::iterator_category());
+  }
+
+  TreeMap(std::initializer_list<value_type> list) : TreeMap(list.begin(), list.end())
+  {}
+
+  /* the copy has the same shape as other, built in one linear pass */
+  TreeMap(const TreeMap& other) : nodeAllocator(node_traits::select_on_container_copy_construction(other.nodeAllocator))
+  {
+    root = cloneSubtree(other.root);
+    size = other.size;
   }
 
-  TreeMap(TreeMap&& other)
+  /* nodes stay where they are, the allocator that owns them comes along */
+  TreeMap(TreeMap&& other) : nodeAllocator(std::move(other.nodeAllocator))
   {
     root = nullptr;
     size = 0;
@@ -216,9 +628,8 @@ public:
   {
     if(this == &other)
       return *this;
-    clearTree();
-    for(auto &item : other)
-      this->operator[](item.first) = item.second;
+    TreeMap copy(other);
+    *this = std::move(copy);
     return *this;
   }
 
@@ -227,6 +638,8 @@ public:
     if(this == &other)
       return *this;
     clearTree();
+    using std::swap;
+    swap(nodeAllocator, other.nodeAllocator);
     std::swap(root, other.root);
     std::swap(size, other.size);
     return *this;
@@ -239,33 +652,72 @@ public:
 
   mapped_type& operator[](const key_type& key)
   {
-    Node* current = root;
-    Node* parent = nullptr;
+    return tryEmplaceNode(key)->data.second;
+  }
 
-    while(current != nullptr)
-    {
-      parent = current;
-      if(key == current->data.first)
-        return current->data.second;
-      else if(key > current->data.first)
-        current = current->rightChild;
-      else
-        current = current->leftChild;
-    }
+  mapped_type& operator[](key_type&& key)
+  {
+    return tryEmplaceNode(std::move(key))->data.second;
+  }
 
-    Node* newElement = new Node(key, mapped_type{}, parent);
-    if(parent == nullptr)
-      root = newElement;
-    else if(key > parent->data.first)
-      parent->rightChild = newElement;
-    else
-      parent->leftChild = newElement;
-    ++size;
-    rebalanceTree(parent);
+  /* inserts (key, mapped_type(args...)) if key is missing, otherwise leaves args untouched; second is true if it inserted */
+  template <typename... Args>
+  std::pair<iterator, bool> tryEmplace(const key_type& key, Args&&... args)
+  {
+    size_type oldSize = size;
+    Node* node = tryEmplaceNode(key, std::forward<Args>(args)...);
+    return std::make_pair(Iterator(this, node), size != oldSize);
+  }
 
-    return newElement->data.second;
+  template <typename... Args>
+  std::pair<iterator, bool> tryEmplace(key_type&& key, Args&&... args)
+  {
+    size_type oldSize = size;
+    Node* node = tryEmplaceNode(std::move(key), std::forward<Args>(args)...);
+    return std::make_pair(Iterator(this, node), size != oldSize);
   }
 
+  /* inserts (key, value) or assigns value to the element already there; second is true if it inserted */
+  template <typename MappedArgument>
+  std::pair<iterator, bool> insertOrAssign(const key_type& key, MappedArgument&& value)
+  {
+    auto result = tryEmplace(key, std::forward<MappedArgument>(value));
+    if(!result.second)
+      result.first->second = std::forward<MappedArgument>(value);
+    return result;
+  }
+
+  template <typename MappedArgument>
+  std::pair<iterator, bool> insertOrAssign(key_type&& key, MappedArgument&& value)
+  {
+    auto result = tryEmplace(std::move(key), std::forward<MappedArgument>(value));
+    if(!result.second)
+      result.first->second = std::forward<MappedArgument>(value);
+    return result;
+  }
+
+  /* node is built from args first, its key is needed to find a place, and freed if the key is already there */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    Node* newElement = createNode(nullptr, std::forward<Args>(args)...);
+    Node* parent = nullptr;
+    bool isRightChild = false;
+    Node* existing = findPlace(newElement->data.first, parent, isRightChild);
+    if(existing != nullptr)
+    {
+      destroyNode(newElement);
+      return std::make_pair(Iterator(this, existing), false);
+    }
+    linkNode(newElement, parent, isRightChild);
+    return std::make_pair(Iterator(this, newElement), true);
+  }
+
+  /* find() and valueOf() also take key types marked by IsTransparentLookup, e.g. const char* or std::string_view
+   * for std::string keys, so no temporary key is built */
+  template <typename LookupKey>
+  using comparable_key = transparent_lookup_key<key_type, LookupKey>;
+
   const mapped_type& valueOf(const key_type& key) const
   {
     auto iteratorToElement = find(key);
@@ -282,34 +734,143 @@ public:
     return (*iteratorToElement).second;
   }
 
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  const mapped_type& valueOf(const LookupKey& key) const
+  {
+    auto iteratorToElement = find(key);
+    if(iteratorToElement == cend())
+      throw std::out_of_range("in function valueOf(const LookupKey&), invalid key");
+    return (*iteratorToElement).second;
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  mapped_type& valueOf(const LookupKey& key)
+  {
+    auto iteratorToElement = find(key);
+    if(iteratorToElement == end())
+      throw std::out_of_range("in function valueOf(const LookupKey&), invalid key");
+    return (*iteratorToElement).second;
+  }
+
   const_iterator find(const key_type& key) const
   {
-    if(isEmpty())
-      return cend();
-    Node* temp = root;
-    while(temp != nullptr && temp->data.first != key)
-    {
-      if(key > temp->data.first)
-        temp = temp->rightChild;
-      else if(key < temp->data.first)
-        temp = temp->leftChild;
-    }
-    return ConstIterator(this, temp);
+    return ConstIterator(this, findNode(key));
   }
 
   iterator find(const key_type& key)
   {
-    if(isEmpty())
-      return end();
-    Node* temp = root;
-    while(temp != nullptr && temp->data.first != key)
-    {
-      if(key > temp->data.first)
-        temp = temp->rightChild;
-      else if(key < temp->data.first)
-        temp = temp->leftChild;
-    }
-    return Iterator(this, temp);
+    return Iterator(this, findNode(key));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  const_iterator find(const LookupKey& key) const
+  {
+    return ConstIterator(this, findNode(key));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  iterator find(const LookupKey& key)
+  {
+    return Iterator(this, findNode(key));
+  }
+
+  /* lowerBound(), upperBound(), equalRange() and range() take the same key types as find(), each one descends the tree once */
+  const_iterator lowerBound(const key_type& key) const
+  {
+    return ConstIterator(this, lowerBoundNode(key));
+  }
+
+  iterator lowerBound(const key_type& key)
+  {
+    return Iterator(this, lowerBoundNode(key));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  const_iterator lowerBound(const LookupKey& key) const
+  {
+    return ConstIterator(this, lowerBoundNode(key));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  iterator lowerBound(const LookupKey& key)
+  {
+    return Iterator(this, lowerBoundNode(key));
+  }
+
+  const_iterator upperBound(const key_type& key) const
+  {
+    return ConstIterator(this, upperBoundNode(key));
+  }
+
+  iterator upperBound(const key_type& key)
+  {
+    return Iterator(this, upperBoundNode(key));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  const_iterator upperBound(const LookupKey& key) const
+  {
+    return ConstIterator(this, upperBoundNode(key));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  iterator upperBound(const LookupKey& key)
+  {
+    return Iterator(this, upperBoundNode(key));
+  }
+
+  /* (lowerBound(key), upperBound(key)), holds at most one element */
+  std::pair<const_iterator, const_iterator> equalRange(const key_type& key) const
+  {
+    auto nodes = equalRangeNodes(key);
+    return std::make_pair(ConstIterator(this, nodes.first), ConstIterator(this, nodes.second));
+  }
+
+  std::pair<iterator, iterator> equalRange(const key_type& key)
+  {
+    auto nodes = equalRangeNodes(key);
+    return std::make_pair(Iterator(this, nodes.first), Iterator(this, nodes.second));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  std::pair<const_iterator, const_iterator> equalRange(const LookupKey& key) const
+  {
+    auto nodes = equalRangeNodes(key);
+    return std::make_pair(ConstIterator(this, nodes.first), ConstIterator(this, nodes.second));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  std::pair<iterator, iterator> equalRange(const LookupKey& key)
+  {
+    auto nodes = equalRangeNodes(key);
+    return std::make_pair(Iterator(this, nodes.first), Iterator(this, nodes.second));
+  }
+
+  /* elements with first <= key < last in order, empty if last <= first, e.g. for(auto& element : map.range(a, b)) */
+  const_range_view range(const key_type& first, const key_type& last) const
+  {
+    auto nodes = rangeNodes(first, last);
+    return const_range_view(ConstIterator(this, nodes.first), ConstIterator(this, nodes.second));
+  }
+
+  range_view range(const key_type& first, const key_type& last)
+  {
+    auto nodes = rangeNodes(first, last);
+    return range_view(Iterator(this, nodes.first), Iterator(this, nodes.second));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  const_range_view range(const LookupKey& first, const LookupKey& last) const
+  {
+    auto nodes = rangeNodes(first, last);
+    return const_range_view(ConstIterator(this, nodes.first), ConstIterator(this, nodes.second));
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  range_view range(const LookupKey& first, const LookupKey& last)
+  {
+    auto nodes = rangeNodes(first, last);
+    return range_view(Iterator(this, nodes.first), Iterator(this, nodes.second));
   }
 
   void remove(const key_type& key)
@@ -317,115 +878,88 @@ public:
     remove(find(key));
   }
 
+  /* node with two children is replaced by its successor, which takes over its height, so rebalancing starts
+   * from the lowest node that lost a descendant */
   void remove(const const_iterator& it)
   {
     if(it == end())
       throw std::out_of_range("in function: remove(const const_iterator&), cannot remove end() or if empty or non-existing element");
     auto nodeToDelete = it.current;
-    auto parentOfDeleted = nodeToDelete->parent;
-    if(nodeToDelete->leftChild == nullptr && nodeToDelete->rightChild == nullptr)
+    Node* rebalanceFrom = nodeToDelete->parent;
+    if(nodeToDelete->leftChild == nullptr || nodeToDelete->rightChild == nullptr)
     {
-      if(parentOfDeleted == nullptr)
-        root = nullptr;
-      else if(nodeToDelete == parentOfDeleted->leftChild)
-        parentOfDeleted->leftChild = nullptr;
-      else 
-        parentOfDeleted->rightChild = nullptr;
-      delete nodeToDelete;
-    }
-    else if(nodeToDelete->leftChild != nullptr && nodeToDelete->rightChild == nullptr)
-    {
-      if(parentOfDeleted == nullptr)
-      {  
-        root = nodeToDelete->leftChild;
-        root->parent = nullptr;
-      }
-      else if(nodeToDelete == parentOfDeleted->leftChild)
-      {
-        parentOfDeleted->leftChild = nodeToDelete->leftChild;
-        nodeToDelete->leftChild->parent = parentOfDeleted;
-      }
-      else
-      {
-        parentOfDeleted->rightChild = nodeToDelete->leftChild;
-        nodeToDelete->leftChild->parent = parentOfDeleted;
-      }
-      delete nodeToDelete;
-    }
-    else if(nodeToDelete->leftChild == nullptr && nodeToDelete->rightChild != nullptr)
-    {
-      if(parentOfDeleted == nullptr)
-      {  
-        root = nodeToDelete->rightChild;
-        root->parent = nullptr;
-      }
-      else if(nodeToDelete == parentOfDeleted->leftChild)
-      {
-        parentOfDeleted->leftChild = nodeToDelete->rightChild;
-        nodeToDelete->rightChild->parent = parentOfDeleted;
-      }
-      else
-      {
-        parentOfDeleted->rightChild = nodeToDelete->rightChild;
-        nodeToDelete->rightChild->parent = parentOfDeleted;
-      }
-      delete nodeToDelete;
+      Node* child = (nodeToDelete->leftChild != nullptr) ? nodeToDelete->leftChild : nodeToDelete->rightChild;
+      replaceChild(nodeToDelete->parent, nodeToDelete, child);
     }
     else
     {
       auto successor = nodeToDelete->rightChild;
-      if(successor->leftChild != nullptr)
-      {
-        while(successor->leftChild != nullptr)
-          successor = successor->leftChild;
-        successor->parent->leftChild = successor->rightChild;
-        if(successor->rightChild != nullptr)
-        successor->rightChild->parent = successor->parent;
-      }
+      while(successor->leftChild != nullptr)
+        successor = successor->leftChild;
+      if(successor->parent == nodeToDelete)
+        rebalanceFrom = successor;
       else
       {
-        successor->parent->rightChild = successor->rightChild;
-        if(successor->rightChild != nullptr)
-          successor->rightChild->parent = successor->parent;
-        Node* temp = successor->parent;
-        while(temp != nullptr)
-        {
-          temp->assignNewHeight();
-          temp = temp->parent;
-        }
-      }
-      if(parentOfDeleted == nullptr)
-      {  
-        root = successor;
-        successor->leftChild = nodeToDelete->leftChild;
-        successor->rightChild = nodeToDelete->rightChild;
-        nodeToDelete->leftChild->parent = successor;
-        nodeToDelete->rightChild->parent = successor;
-        root->parent = nullptr;
-      }
-      else if(nodeToDelete == parentOfDeleted->leftChild)
-      {
-        parentOfDeleted->leftChild = successor;
-        successor->leftChild = nodeToDelete->leftChild;
-        successor->rightChild = nodeToDelete->rightChild;
-        nodeToDelete->leftChild->parent = successor;
-        nodeToDelete->rightChild->parent = successor;
-        successor->parent = nodeToDelete->parent;
-      }
-      else 
-      {
-        parentOfDeleted->rightChild = successor;
-        successor->leftChild = nodeToDelete->leftChild;
+        rebalanceFrom = successor->parent;
+        replaceChild(successor->parent, successor, successor->rightChild);
         successor->rightChild = nodeToDelete->rightChild;
-        nodeToDelete->leftChild->parent = successor;
-        nodeToDelete->rightChild->parent = successor;
-        successor->parent = nodeToDelete->parent;
+        successor->rightChild->parent = successor;
       }
-      delete nodeToDelete;
-      successor->assignNewHeight();
+      successor->leftChild = nodeToDelete->leftChild;
+      successor->leftChild->parent = successor;
+      successor->height = nodeToDelete->height;
+      replaceChild(nodeToDelete->parent, nodeToDelete, successor);
     }
+    destroyNode(nodeToDelete);
     --size;
-    rebalanceTree(parentOfDeleted);
+    rebalanceTree(rebalanceFrom);
+  }
+
+  /* calls visit(key, value) for every element in order of keys, following parent links, so it takes no extra memory
+   * however deep the tree is; visit must not insert or remove elements */
+  template <typename Visitor>
+  void forEach(Visitor visit) const
+  {
+    for(Node* node = leftmostNode(); node != nullptr; node = nextNode(node))
+      visit(static_cast<const key_type&>(node->data.first), static_cast<const mapped_type&>(node->data.second));
+  }
+
+  template <typename Visitor>
+  void forEach(Visitor visit)
+  {
+    for(Node* node = leftmostNode(); node != nullptr; node = nextNode(node))
+      visit(static_cast<const key_type&>(node->data.first), node->data.second);
+  }
+
+  /* k-th smallest element counting from 0, only in trees with order statistics */
+  const_iterator select(size_type k) const
+  {
+    static_assert(OrderStatistics, "select() needs a TreeMap with OrderStatistics");
+    if(k >= size)
+      throw std::out_of_range("in function: select(size_type), k is not less than size");
+    return ConstIterator(this, selectNode(k));
+  }
+
+  iterator select(size_type k)
+  {
+    static_assert(OrderStatistics, "select() needs a TreeMap with OrderStatistics");
+    if(k >= size)
+      throw std::out_of_range("in function: select(size_type), k is not less than size");
+    return Iterator(this, selectNode(k));
+  }
+
+  /* number of keys smaller than key, whether key is in the map or not; select(rank(key)) is then lowerBound(key) */
+  size_type rank(const key_type& key) const
+  {
+    static_assert(OrderStatistics, "rank() needs a TreeMap with OrderStatistics");
+    return rankOf(key);
+  }
+
+  template <typename LookupKey, typename = comparable_key<LookupKey>>
+  size_type rank(const LookupKey& key) const
+  {
+    static_assert(OrderStatistics, "rank() needs a TreeMap with OrderStatistics");
+    return rankOf(key);
   }
 
   size_type getSize() const
@@ -495,21 +1029,22 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Allocator, bool OrderStatistics>
+class TreeMap<KeyType, ValueType, Allocator, OrderStatistics>::ConstIterator
 {
 public:
   using reference = typename TreeMap::const_reference;
   using iterator_category = std::bidirectional_iterator_tag;
   using value_type = typename TreeMap::value_type;
+  using difference_type = std::ptrdiff_t;
   using pointer = const typename TreeMap::value_type*;
 private:
   const TreeMap* tree_ptr;
-  TreeMap<KeyType, ValueType>::Node* current;
-  friend void TreeMap<KeyType, ValueType>::remove(const const_iterator&);
+  TreeMap<KeyType, ValueType, Allocator, OrderStatistics>::Node* current;
+  friend void TreeMap<KeyType, ValueType, Allocator, OrderStatistics>::remove(const const_iterator&);
 
 public:
-  explicit ConstIterator(const TreeMap<KeyType, ValueType>* tree = nullptr, TreeMap<KeyType, ValueType>::Node* curr = nullptr) : tree_ptr(tree), current(curr) {}
+  explicit ConstIterator(const TreeMap<KeyType, ValueType, Allocator, OrderStatistics>* tree = nullptr, TreeMap<KeyType, ValueType, Allocator, OrderStatistics>::Node* curr = nullptr) : tree_ptr(tree), current(curr) {}
 
   ConstIterator(const ConstIterator& other)
   {
@@ -636,14 +1171,14 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::Iterator : public TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Allocator, bool OrderStatistics>
+class TreeMap<KeyType, ValueType, Allocator, OrderStatistics>::Iterator : public TreeMap<KeyType, ValueType, Allocator, OrderStatistics>::ConstIterator
 {
 public:
   using reference = typename TreeMap::reference;
   using pointer = typename TreeMap::value_type*;
 
-  explicit Iterator(const TreeMap<KeyType, ValueType>* tree = nullptr, TreeMap<KeyType, ValueType>::Node* curr = nullptr) : ConstIterator(tree, curr) 
+  explicit Iterator(const TreeMap<KeyType, ValueType, Allocator, OrderStatistics>* tree = nullptr, TreeMap<KeyType, ValueType, Allocator, OrderStatistics>::Node* curr = nullptr) : ConstIterator(tree, curr) 
   {}
 
   Iterator(const ConstIterator& other) : ConstIterator(other)
@@ -0,0 +1,261 @@
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "../BTreeMap.h"
+
+namespace
+{
+
+template <typename KeyType>
+KeyType randomKey(std::mt19937& random, unsigned range);
+
+template <>
+int randomKey<int>(std::mt19937& random, unsigned range)
+{
+  return static_cast<int>(random() % range) * 2;
+}
+
+template <>
+std::string randomKey<std::string>(std::mt19937& random, unsigned range)
+{
+  return "key" + std::to_string(random() % range);
+}
+
+template <typename KeyType>
+void checkSameElements(const aisdi::BTreeMap<KeyType, int>& map, const std::map<KeyType, int>& expected)
+{
+  assert(map.getSize() == expected.size());
+  auto it = expected.begin();
+  for(const auto& element : map)
+  {
+    assert(it != expected.end() && element.first == it->first && element.second == it->second);
+    ++it;
+  }
+  assert(it == expected.end());
+  auto back = expected.rbegin();
+  if(!map.isEmpty())
+  {
+    auto element = map.end();
+    do
+    {
+      --element;
+      assert(element->first == back->first);
+      ++back;
+    } while(element != map.begin());
+  }
+  assert(back == expected.rend());
+}
+
+/* random inserts and removals (by key and by iterator) checked against std::map, leaves split, borrow and merge
+ * all the time with a small key range; copies and moves keep the elements, draining from both ends empties the tree */
+template <typename KeyType>
+void randomOperationsMatchStdMap(unsigned seed, unsigned range)
+{
+  std::mt19937 random(seed);
+  aisdi::BTreeMap<KeyType, int> map;
+  std::map<KeyType, int> expected;
+  for(int i = 0; i < 60000; i++)
+  {
+    KeyType key = randomKey<KeyType>(random, range);
+    unsigned operation = random() % 10;
+    if(operation < 5)
+    {
+      map[key] += i;
+      expected[key] += i;
+    }
+    else if(operation < 7)
+    {
+      bool present = expected.count(key) != 0;
+      try
+      {
+        map.remove(key);
+        assert(present);
+        expected.erase(key);
+      }
+      catch(const std::out_of_range&)
+      {
+        assert(!present);
+      }
+    }
+    else if(operation < 8)
+    {
+      auto it = map.find(key);
+      assert((it == map.end()) == (expected.count(key) == 0));
+      if(it != map.end())
+      {
+        map.remove(it);
+        expected.erase(key);
+      }
+    }
+    else
+    {
+      auto it = map.find(key);
+      assert((it == map.end()) == (expected.count(key) == 0));
+      if(it != map.end())
+        assert(it->second == expected[key]);
+    }
+    if(i % 4999 == 0)
+    {
+      checkSameElements(map, expected);
+      aisdi::BTreeMap<KeyType, int> copy(map);
+      assert(copy == map);
+      aisdi::BTreeMap<KeyType, int> moved(std::move(copy));
+      assert(moved == map && copy.isEmpty());
+      copy = moved;
+      assert(copy == map);
+    }
+  }
+  checkSameElements(map, expected);
+  while(!expected.empty())
+  {
+    KeyType key = (random() % 2) ? expected.begin()->first : expected.rbegin()->first;
+    map.remove(key);
+    expected.erase(key);
+  }
+  assert(map.isEmpty() && map.begin() == map.end());
+}
+
+/* bounds and ranges against std::map for every key between and around the stored ones (all stored keys are even),
+ * on trees from empty to a few levels deep, so bounds fall on leaf ends and into the next leaf */
+void boundsAndRangesMatchStdMap()
+{
+  std::mt19937 random(5);
+  for(unsigned size : {0u, 1u, 3u, 10u, 50u, 300u, 3000u})
+  {
+    aisdi::BTreeMap<int, int> map;
+    std::map<int, int> expected;
+    for(unsigned i = 0; i < size; i++)
+    {
+      int key = randomKey<int>(random, 4 * size + 1);
+      map[key] = static_cast<int>(i);
+      expected[key] = static_cast<int>(i);
+    }
+    for(unsigned i = 0; i < size / 3; i++)
+    {
+      int key = randomKey<int>(random, 4 * size + 1);
+      if(expected.count(key) != 0)
+      {
+        map.remove(key);
+        expected.erase(key);
+      }
+    }
+    const aisdi::BTreeMap<int, int>& constMap = map;
+    for(int key = -3; key <= static_cast<int>(8 * size) + 5; key++)
+    {
+      auto lower = map.lowerBound(key);
+      auto expectedLower = expected.lower_bound(key);
+      assert(std::distance(lower, map.end()) == std::distance(expectedLower, expected.end()));
+      if(expectedLower != expected.end())
+        assert(lower->first == expectedLower->first);
+      auto upper = constMap.upperBound(key);
+      auto expectedUpper = expected.upper_bound(key);
+      assert(std::distance(upper, constMap.end()) == std::distance(expectedUpper, expected.end()));
+      if(expectedUpper != expected.end())
+        assert(upper->first == expectedUpper->first);
+      auto equal = map.equalRange(key);
+      assert(std::distance(equal.first, equal.second) == static_cast<std::ptrdiff_t>(expected.count(key)));
+
+      int last = key + static_cast<int>(random() % 40) - 5;
+      auto it = expected.lower_bound(key);
+      std::size_t inRange = 0;
+      for(const auto& element : constMap.range(key, last))
+      {
+        assert(it != expected.end() && element.first == it->first && element.first < last);
+        ++it;
+        ++inRange;
+      }
+      assert(inRange == ((last > key) ? static_cast<std::size_t>(std::distance(expected.lower_bound(key), expected.lower_bound(last))) : 0));
+    }
+  }
+
+  aisdi::BTreeMap<std::string, int> strings;
+  for(int i = 0; i < 500; i++)
+    strings[std::to_string(i)] = i;
+  assert(strings.lowerBound("250")->first == "250");
+  assert(strings.upperBound("250")->first == "251");
+  std::size_t inRange = 0;
+  for(auto& element : strings.range("1", "2"))
+  {
+    element.second = -1;
+    ++inRange;
+  }
+  assert(inRange == 111);
+  assert(strings.valueOf("199") == -1 && strings.valueOf("2") == 2);
+}
+
+/* numbers are converted to the key type before lookup, strings are found through const char* and std::string_view */
+void lookupWithOtherKeyTypes()
+{
+  aisdi::BTreeMap<int, int> map;
+  for(int i = -10; i <= 5; i++)
+    map[i] = i;
+  assert(map.find(static_cast<std::size_t>(5))->first == 5);
+  assert(map.valueOf(static_cast<std::size_t>(3)) == 3);
+
+  aisdi::BTreeMap<std::string, int> strings{{"a", 1}, {"b", 2}};
+  const char* key = "b";
+  assert(strings.find(key)->second == 2);
+  assert(strings.valueOf("a") == 1);
+#if __cplusplus >= 201703L
+  assert(strings.find(std::string_view("a"))->second == 1);
+#endif
+}
+
+void emplacingAndEmptyMap()
+{
+  aisdi::BTreeMap<int, std::string> map{{1, "a"}, {2, "b"}, {1, "c"}};
+  assert(map.valueOf(1) == "c" && map.getSize() == 2);
+  auto emplaced = map.emplace(3, "x");
+  assert(emplaced.second && emplaced.first->second == "x");
+  assert(!map.emplace(3, "y").second);
+  assert(map.tryEmplace(4, 3, 'z').first->second == "zzz");
+  assert(!map.insertOrAssign(4, std::string("q")).second);
+  assert(map.valueOf(4) == "q");
+
+  aisdi::BTreeMap<int, int> empty;
+  bool thrown = false;
+  try
+  {
+    ++empty.begin();
+  }
+  catch(const std::out_of_range&)
+  {
+    thrown = true;
+  }
+  assert(thrown);
+  thrown = false;
+  try
+  {
+    --empty.end();
+  }
+  catch(const std::out_of_range&)
+  {
+    thrown = true;
+  }
+  assert(thrown);
+  assert(empty.lowerBound(0) == empty.end() && empty.range(0, 10).isEmpty());
+}
+
+} // namespace
+
+int main()
+{
+  for(unsigned seed = 1; seed <= 3; seed++)
+  {
+    randomOperationsMatchStdMap<int>(seed, 100);
+    randomOperationsMatchStdMap<int>(seed, 20000);
+    randomOperationsMatchStdMap<std::string>(seed, 3000);
+  }
+  boundsAndRangesMatchStdMap();
+  lookupWithOtherKeyTypes();
+  emplacingAndEmptyMap();
+  std::cout << "BTreeMap tests passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,161 @@
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "../ConcurrentHashMap.h"
+
+namespace
+{
+
+using Map = aisdi::ConcurrentHashMap<long, int>;
+
+const std::size_t NUM_OF_SHARDS = 64;
+const std::size_t SHARD_CAPACITY = 8192;
+const std::size_t REGIONS = 16;
+
+/* keys that landed in one shard go to slots the hash policy picks for them in a table of that shard's size;
+ * every region of the table has to get a fair share of them and their tags have to differ */
+template <typename HashPolicy>
+void keysOfOneShardSpreadOverItsTable(const std::vector<long>& keys)
+{
+  std::vector<std::size_t> perRegion(REGIONS, 0);
+  std::set<signed char> tags;
+  for(long key : keys)
+  {
+    std::size_t hash = HashPolicy::mix(std::hash<long>()(key));
+    std::size_t position = HashPolicy::positionOf(hash, SHARD_CAPACITY);
+    assert(position < SHARD_CAPACITY);
+    perRegion[position / (SHARD_CAPACITY / REGIONS)]++;
+    tags.insert(HashPolicy::tagOf(hash));
+  }
+  const std::size_t expected = keys.size() / REGIONS;
+  for(std::size_t count : perRegion)
+    assert(count > expected / 2 && count < expected * 2);
+  assert(tags.size() > 100);
+}
+
+void shardChoiceIndependentOfHashPolicies()
+{
+  Map map(NUM_OF_SHARDS);
+  assert(map.getNumOfShards() == NUM_OF_SHARDS);
+
+  std::vector<std::size_t> perShard(NUM_OF_SHARDS, 0);
+  std::vector<long> firstShardKeys;
+  for(long key = 0; firstShardKeys.size() < SHARD_CAPACITY / 2; key += 7)
+  {
+    std::size_t shard = map.shardIndexOf(key);
+    assert(shard < NUM_OF_SHARDS);
+    perShard[shard]++;
+    if(shard == 0)
+      firstShardKeys.push_back(key);
+  }
+  const std::size_t expected = SHARD_CAPACITY / 2;
+  for(std::size_t count : perShard)
+    assert(count > expected / 2 && count < expected * 2);
+
+  keysOfOneShardSpreadOverItsTable<aisdi::MaskHashPolicy>(firstShardKeys);
+  keysOfOneShardSpreadOverItsTable<aisdi::MixingHashPolicy>(firstShardKeys);
+  keysOfOneShardSpreadOverItsTable<aisdi::FibonacciHashPolicy>(firstShardKeys);
+}
+
+const int THREADS = 4;
+const int ROUNDS = 20000;
+const long SHARED_KEYS = 97;
+
+/* pair of keys of one writer thread, both set to the same round number, first one first */
+long leadingKey(int thread)
+{
+  return 1000 + 2 * thread;
+}
+
+long trailingKey(int thread)
+{
+  return 1001 + 2 * thread;
+}
+
+/* writers upsert counters of shared keys and move their own pair of keys forward while readers look values up
+ * and take snapshots; at the end the map has to hold what the same operations give when done one after another */
+void concurrentOperationsMatchSerialMap()
+{
+  Map map(8);
+  std::vector<std::thread> threads;
+  for(int t = 0; t < THREADS; t++)
+    threads.emplace_back([&map, t]() {
+      for(int round = 1; round <= ROUNDS; round++)
+      {
+        map.upsert((round * 31 + t) % SHARED_KEYS, 1, [](int& value) { ++value; });
+        map.insertOrAssign(leadingKey(t), round);
+        map.insertOrAssign(trailingKey(t), round);
+      }
+    });
+
+  for(int t = 0; t < THREADS; t++)
+    threads.emplace_back([&map]() {
+      std::vector<int> lastSeen(SHARED_KEYS, 0);
+      for(int round = 0; round < ROUNDS / 10; round++)
+      {
+        long key = round % SHARED_KEYS;
+        int value = 0;
+        if(map.find(key, value))
+        {
+          assert(value >= lastSeen[key]);                 // counters only grow
+          lastSeen[key] = value;
+        }
+        if(round % 100 == 0)
+        {
+          Map::shard_map copy = map.snapshot();
+          for(int writer = 0; writer < THREADS; writer++)
+          {
+            auto leading = copy.find(leadingKey(writer));
+            auto trailing = copy.find(trailingKey(writer));
+            if(trailing == copy.end())
+              continue;
+            assert(leading != copy.end());
+            assert(leading->second - trailing->second <= 1 && leading->second >= trailing->second);
+          }
+        }
+      }
+    });
+
+  for(auto& thread : threads)
+    thread.join();
+
+  std::map<long, int> serial;
+  for(int t = 0; t < THREADS; t++)
+    for(int round = 1; round <= ROUNDS; round++)
+    {
+      ++serial[(round * 31 + t) % SHARED_KEYS];
+      serial[leadingKey(t)] = ROUNDS;
+      serial[trailingKey(t)] = ROUNDS;
+    }
+
+  Map::shard_map copy = map.snapshot();
+  assert(copy.getSize() == serial.size());
+  assert(map.getSize() == serial.size());
+  for(const auto& element : serial)
+  {
+    assert(map.valueOf(element.first) == element.second);
+    assert(copy.valueOf(element.first) == element.second);
+  }
+  std::size_t visited = 0;
+  map.forEach([&serial, &visited](long key, int value) {
+    assert(serial.at(key) == value);
+    ++visited;
+  });
+  assert(visited == serial.size());
+}
+
+} // namespace
+
+int main()
+{
+  shardChoiceIndependentOfHashPolicies();
+  concurrentOperationsMatchSerialMap();
+  std::cout << "ConcurrentHashMap tests passed" << std::endl;
+  return 0;
+}
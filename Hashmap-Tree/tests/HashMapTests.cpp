@@ -0,0 +1,315 @@
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../HashMap.h"
+
+namespace
+{
+
+using Map = aisdi::HashMap<std::string, int>;
+
+/* map[it->first] while the map is growing incrementally: the key lives in a slot the migration step may move,
+ * every element is tried on a fresh copy, so each one is hit while it still waits in the old table */
+void indexingWithOwnKeyDuringIncrementalResize()
+{
+  Map map;
+  map.setRehashMode(Map::INCREMENTAL);
+  for(int i = 0; i < 300; i++)
+  {
+    map["key-number-" + std::to_string(i)] = 0;
+    for(std::size_t j = 0; j < map.getSize(); j++)
+    {
+      Map copy(map);
+      auto it = copy.begin();
+      std::advance(it, j);
+      std::string key = it->first;
+      ++copy[it->first];
+      assert(copy.getSize() == map.getSize());
+      assert(copy.valueOf(key) == 1);
+    }
+  }
+}
+
+template <typename HashMapType>
+void checkSameElements(const HashMapType& map, const std::unordered_map<long, long>& expected)
+{
+  assert(map.getSize() == expected.size());
+  std::size_t forward = 0;
+  for(const auto& element : map)
+  {
+    assert(expected.at(element.first) == element.second);
+    ++forward;
+  }
+  assert(forward == expected.size());
+  std::size_t backward = 0;
+  if(!map.isEmpty())
+  {
+    auto it = map.end();
+    do
+    {
+      --it;
+      ++backward;
+    } while(it != map.begin());
+  }
+  assert(backward == expected.size());
+}
+
+/* random inserts, updates and removals (by key and by iterator) checked against std::unordered_map in both rehash modes;
+ * keys are multiples of 1024, which leave low bits of the hash empty unless the policy mixes them in */
+template <typename HashPolicy>
+void randomOperationsMatchUnorderedMap(bool incremental)
+{
+  using PolicyMap = aisdi::HashMap<long, long, std::hash<long>, std::equal_to<long>, HashPolicy>;
+  std::mt19937 random(incremental ? 7 : 3);
+  PolicyMap map;
+  if(incremental)
+    map.setRehashMode(PolicyMap::INCREMENTAL);
+  std::unordered_map<long, long> expected;
+  for(long i = 0; i < 60000; i++)
+  {
+    long key = static_cast<long>(random() % 5000) * 1024;
+    unsigned operation = random() % 10;
+    if(operation < 5)
+    {
+      map[key] += i;
+      expected[key] += i;
+    }
+    else if(operation < 7)
+    {
+      bool present = expected.count(key) != 0;
+      try
+      {
+        map.remove(key);
+        assert(present);
+        expected.erase(key);
+      }
+      catch(const std::out_of_range&)
+      {
+        assert(!present);
+      }
+    }
+    else if(operation < 8)
+    {
+      auto it = map.find(key);
+      assert((it == map.end()) == (expected.count(key) == 0));
+      if(it != map.end())
+      {
+        map.remove(it);
+        expected.erase(key);
+      }
+    }
+    else
+    {
+      auto it = map.find(key);
+      assert((it == map.end()) == (expected.count(key) == 0));
+      if(it != map.end())
+        assert(it->second == expected[key]);
+    }
+    if(i % 4999 == 0)
+    {
+      checkSameElements(map, expected);
+      PolicyMap copy(map);
+      assert(copy == map);
+      PolicyMap moved(std::move(copy));
+      assert(moved == map && copy.isEmpty());
+      copy = moved;
+      assert(copy == map);
+    }
+  }
+  checkSameElements(map, expected);
+}
+
+/* begin() stays right while elements are removed from the front and the table is left nearly empty */
+void iterationAfterDrainingFromFront()
+{
+  aisdi::HashMap<long, long> map;
+  for(long i = 0; i < 20000; i++)
+    map[i * 7919] = i;
+  while(map.getSize() > 10)
+    map.remove(map.begin());
+  std::unordered_map<long, long> expected;
+  for(const auto& element : map)
+    expected[element.first] = element.second;
+  assert(expected.size() == 10);
+  checkSameElements(map, expected);
+
+  aisdi::HashMap<int, int> empty;
+  assert(empty.begin() == empty.end());
+  bool thrown = false;
+  try
+  {
+    ++empty.begin();
+  }
+  catch(const std::out_of_range&)
+  {
+    thrown = true;
+  }
+  assert(thrown);
+  thrown = false;
+  try
+  {
+    --empty.end();
+  }
+  catch(const std::out_of_range&)
+  {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+/* range constructor keeps the last value of a repeated key, reserve() and insert() leave the same elements */
+void bulkConstructionAndReserve()
+{
+  std::vector<std::pair<int, int>> elements;
+  for(int i = 0; i < 30000; i++)
+    elements.push_back(std::make_pair(i % 20000, i));
+  aisdi::HashMap<int, int> built(elements.begin(), elements.end());
+  assert(built.getSize() == 20000);
+  assert(built.valueOf(5) == 20005);
+  assert(built.valueOf(19999) == 19999);
+
+  aisdi::HashMap<int, int> reserved;
+  reserved.reserve(20000);
+  reserved.insert(elements.begin(), elements.end());
+  assert(reserved == built);
+
+  aisdi::HashMap<int, int> list{{1, 1}, {1, 2}};
+  assert(list.getSize() == 1 && list.valueOf(1) == 2);
+}
+
+struct Counted
+{
+  static int copies;
+  std::string text;
+
+  explicit Counted(std::string from) : text(std::move(from))
+  {}
+
+  Counted(const Counted& other) : text(other.text)
+  {
+    ++copies;
+  }
+
+  Counted(Counted&& other) : text(std::move(other.text))
+  {}
+
+  Counted& operator=(const Counted& other)
+  {
+    text = other.text;
+    ++copies;
+    return *this;
+  }
+
+  Counted& operator=(Counted&& other)
+  {
+    text = std::move(other.text);
+    return *this;
+  }
+
+  bool operator==(const Counted& other) const
+  {
+    return text == other.text;
+  }
+};
+
+int Counted::copies = 0;
+
+struct CountedHash
+{
+  std::size_t operator()(const Counted& counted) const
+  {
+    return std::hash<std::string>()(counted.text);
+  }
+};
+
+/* tryEmplace(), insertOrAssign() and emplace() build keys and values in place and move them when the table grows,
+ * in both rehash modes, so move-only keys work and copyable ones are never copied */
+void emplacingNeverCopies(bool incremental)
+{
+  using CountedMap = aisdi::HashMap<Counted, Counted, CountedHash>;
+  CountedMap map;
+  if(incremental)
+    map.setRehashMode(CountedMap::INCREMENTAL);
+  Counted::copies = 0;
+  for(int i = 0; i < 5000; i++)
+    map.emplace(Counted("key" + std::to_string(i)), Counted("value"));
+  for(int i = 0; i < 5000; i++)
+    assert(!map.tryEmplace(Counted("key" + std::to_string(i)), "other").second);
+  for(int i = 0; i < 5000; i += 2)
+    assert(!map.insertOrAssign(Counted("key" + std::to_string(i)), Counted("even")).second);
+  for(int i = 0; i < 5000; i++)
+    map.tryEmplace(Counted("new" + std::to_string(i)), "new");
+  assert(Counted::copies == 0);
+  assert(map.getSize() == 10000);
+  assert(map.valueOf(Counted("key2")).text == "even");
+  assert(map.valueOf(Counted("key3")).text == "value");
+
+  using PointerMap = aisdi::HashMap<std::unique_ptr<int>, int>;
+  PointerMap pointers;
+  if(incremental)
+    pointers.setRehashMode(PointerMap::INCREMENTAL);
+  for(int i = 0; i < 5000; i++)
+    pointers.emplace(std::unique_ptr<int>(new int(i)), i);
+  long sum = 0;
+  for(const auto& element : pointers)
+  {
+    assert(*element.first == element.second);
+    sum += element.second;
+  }
+  assert(sum == 5000L * 4999 / 2);
+}
+
+#if __cplusplus >= 201703L
+/* string keys found through const char* and std::string_view with transparent hasher and equality */
+void heterogeneousLookup()
+{
+  aisdi::HashMap<std::string, int, aisdi::StringHash, std::equal_to<>> map;
+  for(int i = 0; i < 1000; i++)
+    map["a key long enough to be allocated " + std::to_string(i)] = i;
+  const char* probe = "a key long enough to be allocated 777";
+  assert(map.valueOf(probe) == 777);
+  assert(map.find(std::string_view(probe))->second == 777);
+  assert(map.find("missing") == map.end());
+  bool thrown = false;
+  try
+  {
+    map.valueOf("missing");
+  }
+  catch(const std::out_of_range&)
+  {
+    thrown = true;
+  }
+  assert(thrown);
+}
+#endif
+
+} // namespace
+
+int main()
+{
+  indexingWithOwnKeyDuringIncrementalResize();
+  for(bool incremental : {false, true})
+  {
+    randomOperationsMatchUnorderedMap<aisdi::MaskHashPolicy>(incremental);
+    randomOperationsMatchUnorderedMap<aisdi::MixingHashPolicy>(incremental);
+    randomOperationsMatchUnorderedMap<aisdi::FibonacciHashPolicy>(incremental);
+    emplacingNeverCopies(incremental);
+  }
+  iterationAfterDrainingFromFront();
+  bulkConstructionAndReserve();
+#if __cplusplus >= 201703L
+  heterogeneousLookup();
+#endif
+  std::cout << "HashMap tests passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../TreeMap.h"
+
+namespace
+{
+
+using Element = std::pair<const int, int>;
+using PooledMap = aisdi::TreeMap<int, int>;
+using PlainMap = aisdi::TreeMap<int, int, std::allocator<Element>>;
+using RankedMap = aisdi::TreeMap<int, int, aisdi::NodePool<Element>, true>;
+
+template <typename TreeMapType>
+void checkSameElements(const TreeMapType& map, const std::map<int, int>& expected)
+{
+  assert(map.getSize() == expected.size());
+  auto it = expected.begin();
+  for(const auto& element : map)
+  {
+    assert(it != expected.end() && element.first == it->first && element.second == it->second);
+    ++it;
+  }
+  assert(it == expected.end());
+  auto back = expected.rbegin();
+  if(!map.isEmpty())
+  {
+    auto element = map.end();
+    do
+    {
+      --element;
+      assert(element->first == back->first);
+      ++back;
+    } while(element != map.begin());
+  }
+  assert(back == expected.rend());
+}
+
+/* random inserts and removals checked against std::map, with nodes from a NodePool (reusing freed nodes)
+ * or from std::allocator, copies and moves keep the elements */
+template <typename TreeMapType>
+void randomOperationsMatchStdMap(unsigned seed)
+{
+  std::mt19937 random(seed);
+  TreeMapType map;
+  std::map<int, int> expected;
+  const int range = (seed % 2) ? 50 : 3000;
+  for(int i = 0; i < 40000; i++)
+  {
+    int key = static_cast<int>(random() % range);
+    if(random() % 3 != 0)
+    {
+      map[key] += i;
+      expected[key] += i;
+    }
+    else
+    {
+      bool present = expected.count(key) != 0;
+      try
+      {
+        map.remove(key);
+        assert(present);
+        expected.erase(key);
+      }
+      catch(const std::out_of_range&)
+      {
+        assert(!present);
+      }
+    }
+    if(i % 4999 == 0)
+    {
+      checkSameElements(map, expected);
+      TreeMapType copy(map);
+      assert(copy == map);
+      TreeMapType moved(std::move(copy));
+      assert(moved == map && copy.isEmpty());
+      copy = moved;
+      assert(copy == map);
+      moved = TreeMapType();
+      moved[1] = 1;
+      assert(moved.getSize() == 1);
+    }
+  }
+  checkSameElements(map, expected);
+  while(!expected.empty())
+  {
+    map.remove(expected.begin()->first);
+    expected.erase(expected.begin());
+  }
+  assert(map.isEmpty() && map.begin() == map.end());
+}
+
+/* a sorted range is built directly, an unsorted one goes element by element, a repeated key keeps its last value
+ * either way */
+void constructionFromRanges()
+{
+  std::vector<std::pair<int, int>> sorted;
+  std::map<int, int> expected;
+  for(int i = 0; i < 10000; i++)
+  {
+    sorted.push_back(std::make_pair(i / 2 * 3, i));
+    expected[i / 2 * 3] = i;
+  }
+  checkSameElements(PooledMap(sorted.begin(), sorted.end()), expected);
+  checkSameElements(RankedMap(sorted.begin(), sorted.end()), expected);
+
+  std::vector<std::pair<int, int>> shuffled(sorted);
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(2));
+  PooledMap fromShuffled(shuffled.begin(), shuffled.end());
+  assert(fromShuffled.getSize() == expected.size());
+  for(const auto& element : fromShuffled)
+    assert(expected.count(element.first) != 0);
+
+  PooledMap list{{3, 1}, {1, 1}, {3, 2}};
+  assert(list.getSize() == 2 && list.valueOf(3) == 2);
+}
+
+/* lowerBound(), upperBound(), equalRange() and range() against std::map for every key around the stored ones */
+void boundsAndRangesMatchStdMap()
+{
+  std::mt19937 random(5);
+  PooledMap map;
+  std::map<int, int> expected;
+  for(int i = 0; i < 3000; i++)
+  {
+    int key = static_cast<int>(random() % 5000);
+    map[key] = i;
+    expected[key] = i;
+  }
+  const PooledMap& constMap = map;
+  for(int key = -10; key < 5010; key++)
+  {
+    auto lower = map.lowerBound(key);
+    auto expectedLower = expected.lower_bound(key);
+    assert((lower == map.end()) == (expectedLower == expected.end()));
+    if(expectedLower != expected.end())
+      assert(lower->first == expectedLower->first);
+    auto upper = constMap.upperBound(key);
+    auto expectedUpper = expected.upper_bound(key);
+    assert((upper == constMap.end()) == (expectedUpper == expected.end()));
+    if(expectedUpper != expected.end())
+      assert(upper->first == expectedUpper->first);
+    auto equal = map.equalRange(key);
+    assert(std::distance(equal.first, equal.second) == static_cast<std::ptrdiff_t>(expected.count(key)));
+
+    int last = key + static_cast<int>(random() % 400) - 100;
+    auto it = expected.lower_bound(key);
+    std::size_t inRange = 0;
+    for(const auto& element : constMap.range(key, last))
+    {
+      assert(it != expected.end() && element.first == it->first && element.first < last);
+      ++it;
+      ++inRange;
+    }
+    assert(inRange == ((last > key) ? static_cast<std::size_t>(std::distance(expected.lower_bound(key), expected.lower_bound(last))) : 0));
+  }
+  for(auto& element : map.range(10, 20))
+    element.second = -1;
+  for(auto it = map.lowerBound(10); it != map.lowerBound(20); ++it)
+    assert(it->second == -1);
+
+  aisdi::TreeMap<std::string, int> strings{{"apple", 1}, {"banana", 2}, {"cherry", 3}};
+  std::size_t fruits = 0;
+  for(const auto& element : strings.range("b", "cz"))
+  {
+    (void)element;
+    ++fruits;
+  }
+  assert(fruits == 2);
+  assert(strings.lowerBound("c")->first == "cherry");
+  assert(strings.upperBound("cherry") == strings.end());
+  assert(strings.range("z", "a").isEmpty());
+}
+
+/* a lookup key of another numeric type is converted to the key type first, so a size_t finds the same as an int */
+void lookupWithOtherKeyTypes()
+{
+  PooledMap map;
+  for(int i = -10; i <= 5; i++)
+    map[i] = i;
+  assert(map.find(static_cast<std::size_t>(5))->first == 5);
+  assert(map.valueOf(static_cast<std::size_t>(3)) == 3);
+  assert(map.lowerBound(static_cast<std::size_t>(5))->first == 5);
+
+  aisdi::TreeMap<std::string, int> strings{{"a", 1}, {"b", 2}};
+  const char* key = "b";
+  assert(strings.find(key)->second == 2);
+  assert(strings.valueOf("a") == 1);
+#if __cplusplus >= 201703L
+  assert(strings.find(std::string_view("a"))->second == 1);
+#endif
+}
+
+/* select() and rank() agree with positions in std::map after removals, bulk building and copying */
+void orderStatisticsMatchStdMap()
+{
+  std::mt19937 random(1);
+  RankedMap map;
+  std::map<int, int> expected;
+  for(int i = 0; i < 20000; i++)
+  {
+    int key = static_cast<int>(random() % 30000);
+    if(random() % 4 == 0)
+    {
+      if(expected.count(key) != 0)
+      {
+        map.remove(key);
+        expected.erase(key);
+      }
+    }
+    else
+    {
+      map[key] = i;
+      expected[key] = i;
+    }
+  }
+  RankedMap copy(map);
+  std::vector<std::pair<int, int>> sorted(expected.begin(), expected.end());
+  RankedMap built(sorted.begin(), sorted.end());
+  std::size_t position = 0;
+  for(const auto& element : expected)
+  {
+    assert(map.select(position)->first == element.first);
+    assert(copy.select(position)->first == element.first);
+    assert(built.select(position)->first == element.first);
+    ++position;
+  }
+  for(int key = -5; key < 30005; key += 3)
+  {
+    std::size_t smaller = static_cast<std::size_t>(std::distance(expected.begin(), expected.lower_bound(key)));
+    assert(map.rank(key) == smaller);
+    assert(built.rank(key) == smaller);
+  }
+  bool thrown = false;
+  try
+  {
+    map.select(expected.size());
+  }
+  catch(const std::out_of_range&)
+  {
+    thrown = true;
+  }
+  assert(thrown);
+  const RankedMap& constMap = map;
+  assert(constMap.select(0) == constMap.cbegin());
+}
+
+/* forEach() visits elements in order and may change values; large trees are torn down and replaced */
+void forEachAndTeardown()
+{
+  aisdi::TreeMap<std::string, std::string> map;
+  std::map<std::string, std::string> expected;
+  for(int i = 0; i < 5000; i++)
+  {
+    std::string key = std::to_string(i * 7919 % 10007);
+    map[key] = key + "v";
+    expected[key] = key + "v";
+  }
+  auto it = expected.begin();
+  map.forEach([&it](const std::string& key, std::string& value) {
+    assert(key == it->first && value == it->second);
+    value += "x";
+    ++it;
+  });
+  assert(it == expected.end());
+  const auto& constMap = map;
+  std::size_t visited = 0;
+  constMap.forEach([&visited](const std::string&, const std::string& value) {
+    assert(value.back() == 'x');
+    ++visited;
+  });
+  assert(visited == expected.size());
+  aisdi::TreeMap<std::string, std::string> empty;
+  empty.forEach([](const std::string&, std::string&) { assert(false); });
+
+  std::vector<std::pair<int, int>> sorted;
+  for(int i = 0; i < (1 << 18); i++)
+    sorted.push_back(std::make_pair(i, i));
+  PooledMap big(sorted.begin(), sorted.end());
+  PlainMap plain(sorted.begin(), sorted.end());
+  long long sum = 0;
+  big.forEach([&sum](const int& key, int& value) { sum += key - value; });
+  assert(sum == 0);
+  big = PooledMap();
+  plain = PlainMap();
+  assert(big.isEmpty() && plain.isEmpty());
+  big[1] = 1;
+  assert(big.getSize() == 1);
+}
+
+} // namespace
+
+int main()
+{
+  for(unsigned seed = 0; seed < 4; seed++)
+  {
+    randomOperationsMatchStdMap<PooledMap>(seed);
+    randomOperationsMatchStdMap<PlainMap>(seed);
+    randomOperationsMatchStdMap<RankedMap>(seed);
+  }
+  constructionFromRanges();
+  boundsAndRangesMatchStdMap();
+  lookupWithOtherKeyTypes();
+  orderStatisticsMatchStdMap();
+  forEachAndTeardown();
+  std::cout << "TreeMap tests passed" << std::endl;
+  return 0;
+}